@@ -0,0 +1,641 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Cpu.h"
+#include "MoveGen.h"
+#include "Position.h"
+#include "Search.h"
+
+namespace
+{
+	// The standard perft suite positions plus a few quiet middlegames, so every bench runs on identical input.
+	// The start position is spelled out: StartFen, defined in another file, may not be constructed yet.
+	const std::vector<std::string> BenchFens =
+	{
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		"r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1BBPPP/R2QK2R w KQ - 0 9",
+		"2r2rk1/1bqnbppp/p2ppn2/1p6/3NP3/1BN1BP2/PPPQ2PP/2KR3R w - - 0 14",
+		"8/5pk1/6p1/3R4/5P2/6PK/r7/8 b - - 0 45"
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	double MillisecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	struct SliderQuery
+	{
+		PieceType type;
+		Square square;
+		Bitboard occupied;
+	};
+
+	std::vector<SliderQuery> CollectSliderQueries()
+	{
+		std::vector<SliderQuery> queries;
+		Position position;
+		for (const std::string& fen : BenchFens)
+		{
+			position.SetFromFen(fen);
+			for (PieceType type : { BISHOP, ROOK, QUEEN })
+			{
+				Bitboard sliders = position.Pieces(type);
+				while (sliders)
+				{
+					queries.push_back({ type, PopLsb(sliders), position.Pieces() });
+				}
+			}
+		}
+		return queries;
+	}
+
+	Bitboard MagicAttacks(const SliderQuery& query)
+	{
+		switch (query.type)
+		{
+		case BISHOP: return BishopAttacks(query.square, query.occupied);
+		case ROOK: return RookAttacks(query.square, query.occupied);
+		default: return QueenAttacks(query.square, query.occupied);
+		}
+	}
+
+	double TimeSliderQueries(const char* name, const std::vector<SliderQuery>& queries, int iterations, Bitboard (*attacks)(const SliderQuery&))
+	{
+		Bitboard sink = 0;
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			for (const SliderQuery& query : queries)
+			{
+				sink += attacks(query);
+			}
+		}
+		double ms = MillisecondsSince(start);
+		double lookups = double(iterations) * queries.size();
+		std::printf("%-10s %10.1f ms %8.2f ns/query  (checksum %016llx)\n", name, ms, ms * 1e6 / lookups, (unsigned long long)sink);
+		return ms;
+	}
+
+	Bitboard RayWalkAttacks(const SliderQuery& query)
+	{
+		return RayAttacks(query.type, query.square, query.occupied);
+	}
+
+	// Ray walking versus magic lookups for every slider of every bench position.
+	void BenchSliders(int iterations)
+	{
+		std::vector<SliderQuery> queries = CollectSliderQueries();
+		for (const SliderQuery& query : queries)
+		{
+			if (MagicAttacks(query) != RayWalkAttacks(query))
+			{
+				std::printf("mismatch on square %d\n", query.square);
+				std::exit(1);
+			}
+		}
+
+		std::printf("sliders: %zu queries from %zu positions, %d iterations\n", queries.size(), BenchFens.size(), iterations);
+		double rayMs = TimeSliderQueries("ray walk", queries, iterations, RayWalkAttacks);
+		double magicMs = TimeSliderQueries(GetSliderBackend() == SliderBackend::PEXT ? "pext" : "magic", queries, iterations, MagicAttacks);
+		std::printf("speedup    %10.2fx\n", rayMs / magicMs);
+	}
+
+	// Magic multiplication versus PEXT indexing on the same queries, reported per CPU model.
+	void BenchPext(int iterations)
+	{
+		const CpuInfo& cpu = GetCpuInfo();
+		std::printf("cpu: %s (%s family 0x%x model 0x%x) bmi2: %s fast pext: %s\n",
+			cpu.brand.c_str(), cpu.vendor.c_str(), cpu.family, cpu.model, cpu.bmi2 ? "yes" : "no", cpu.fastPext ? "yes" : "no");
+
+		std::vector<SliderQuery> queries = CollectSliderQueries();
+		SliderBackend initial = GetSliderBackend();
+
+		SetSliderBackend(SliderBackend::MAGIC);
+		double magicMs = TimeSliderQueries("magic", queries, iterations, MagicAttacks);
+		if (SetSliderBackend(SliderBackend::PEXT))
+		{
+			double pextMs = TimeSliderQueries("pext", queries, iterations, MagicAttacks);
+			std::printf("speedup    %10.2fx\n", magicMs / pextMs);
+		}
+		else
+		{
+			std::printf("pext backend not available on this cpu or build\n");
+		}
+		SetSliderBackend(initial);
+	}
+
+	// The GUI's piece rules as they were before move generation was specialized: every piece owns a
+	// heap-allocated MovementValidator and KillableFinder, and each query is a virtual call. The rules
+	// are completed here with double pushes, promotions, en passant, castling and the king's diagonals,
+	// and each move is tested for leaving the king in check, so that they give exactly the legal moves.
+	struct MovementValidator
+	{
+		virtual ~MovementValidator() = default;
+		// Empty squares the piece can move to, checks and pins aside.
+		virtual Bitboard GetValidSquares(Color color, Square from, const Position& position) const = 0;
+	};
+
+	struct KillableFinder
+	{
+		virtual ~KillableFinder() = default;
+		// Squares of the enemy pieces the piece can take, checks and pins aside.
+		virtual Bitboard GetKillableSquares(Color color, Square from, const Position& position) const = 0;
+	};
+
+	struct PawnMovementValidator : public MovementValidator
+	{
+		Bitboard GetValidSquares(Color color, Square from, const Position& position) const override
+		{
+			Square single = from + PawnPush(color);
+			if (!position.Empty(single))
+				return 0;
+			Bitboard squares = SquareBB(single);
+			if (RelativeRank(color, RankOf(from)) == RANK_2 && position.Empty(single + PawnPush(color)))
+				squares |= SquareBB(single + PawnPush(color));
+			return squares;
+		}
+	};
+
+	struct KingMovementValidator : public MovementValidator
+	{
+		Bitboard GetValidSquares(Color color, Square from, const Position& position) const override
+		{
+			Bitboard squares = KingAttacks(from) & ~position.Pieces();
+			// Castling is offered as the king's move; whether it passes through check is up to the legality test.
+			int kingSide = color == WHITE ? WHITE_OO : BLACK_OO;
+			int queenSide = color == WHITE ? WHITE_OOO : BLACK_OOO;
+			if ((position.CastlingRights() & kingSide) && position.PieceOn(RelativeSquare(color, SQ_H1)) == MakePiece(color, ROOK)
+				&& position.Empty(RelativeSquare(color, SQ_F1)) && position.Empty(RelativeSquare(color, SQ_G1)))
+			{
+				squares |= SquareBB(RelativeSquare(color, SQ_G1));
+			}
+			if ((position.CastlingRights() & queenSide) && position.PieceOn(RelativeSquare(color, SQ_A1)) == MakePiece(color, ROOK)
+				&& position.Empty(RelativeSquare(color, SQ_D1)) && position.Empty(RelativeSquare(color, SQ_C1))
+				&& position.Empty(RelativeSquare(color, SQ_B1)))
+			{
+				squares |= SquareBB(RelativeSquare(color, SQ_C1));
+			}
+			return squares;
+		}
+	};
+
+	struct KnightMovementValidator : public MovementValidator
+	{
+		Bitboard GetValidSquares(Color, Square from, const Position& position) const override
+		{
+			return KnightAttacks(from) & ~position.Pieces();
+		}
+	};
+
+	struct BishopMovementValidator : public MovementValidator
+	{
+		Bitboard GetValidSquares(Color, Square from, const Position& position) const override
+		{
+			return BishopAttacks(from, position.Pieces()) & ~position.Pieces();
+		}
+	};
+
+	struct RookMovementValidator : public MovementValidator
+	{
+		Bitboard GetValidSquares(Color, Square from, const Position& position) const override
+		{
+			return RookAttacks(from, position.Pieces()) & ~position.Pieces();
+		}
+	};
+
+	struct QueenMovementValidator : public MovementValidator
+	{
+		Bitboard GetValidSquares(Color, Square from, const Position& position) const override
+		{
+			return QueenAttacks(from, position.Pieces()) & ~position.Pieces();
+		}
+	};
+
+	struct PawnKillableFinder : public KillableFinder
+	{
+		Bitboard GetKillableSquares(Color color, Square from, const Position& position) const override
+		{
+			Bitboard targets = position.Pieces(~color);
+			if (position.EpSquare() != SQ_NONE)
+				targets |= SquareBB(position.EpSquare());
+			return PawnAttacks(color, from) & targets;
+		}
+	};
+
+	struct KingKillableFinder : public KillableFinder
+	{
+		Bitboard GetKillableSquares(Color color, Square from, const Position& position) const override
+		{
+			return KingAttacks(from) & position.Pieces(~color);
+		}
+	};
+
+	struct KnightKillableFinder : public KillableFinder
+	{
+		Bitboard GetKillableSquares(Color color, Square from, const Position& position) const override
+		{
+			return KnightAttacks(from) & position.Pieces(~color);
+		}
+	};
+
+	struct BishopKillableFinder : public KillableFinder
+	{
+		Bitboard GetKillableSquares(Color color, Square from, const Position& position) const override
+		{
+			return BishopAttacks(from, position.Pieces()) & position.Pieces(~color);
+		}
+	};
+
+	struct RookKillableFinder : public KillableFinder
+	{
+		Bitboard GetKillableSquares(Color color, Square from, const Position& position) const override
+		{
+			return RookAttacks(from, position.Pieces()) & position.Pieces(~color);
+		}
+	};
+
+	struct QueenKillableFinder : public KillableFinder
+	{
+		Bitboard GetKillableSquares(Color color, Square from, const Position& position) const override
+		{
+			return QueenAttacks(from, position.Pieces()) & position.Pieces(~color);
+		}
+	};
+
+	struct ValidatedPiece
+	{
+		ValidatedPiece(PieceCode piece, Square square) :
+			square{ square }, color{ ColorOf(piece) }
+		{
+			switch (TypeOf(piece))
+			{
+			case PAWN: validator.reset(new PawnMovementValidator{}); finder.reset(new PawnKillableFinder{}); break;
+			case KNIGHT: validator.reset(new KnightMovementValidator{}); finder.reset(new KnightKillableFinder{}); break;
+			case BISHOP: validator.reset(new BishopMovementValidator{}); finder.reset(new BishopKillableFinder{}); break;
+			case ROOK: validator.reset(new RookMovementValidator{}); finder.reset(new RookKillableFinder{}); break;
+			case QUEEN: validator.reset(new QueenMovementValidator{}); finder.reset(new QueenKillableFinder{}); break;
+			default: validator.reset(new KingMovementValidator{}); finder.reset(new KingKillableFinder{}); break;
+			}
+		}
+
+		Square square;
+		Color color;
+		std::unique_ptr<MovementValidator> validator;
+		std::unique_ptr<KillableFinder> finder;
+	};
+
+	// Whether the move leaves the mover's king out of check, from the attackers to the king once
+	// the move has changed the occupancy. Castling may not start in, pass through or end in check.
+	bool KeepsKingSafe(const Position& position, Move move)
+	{
+		Color us = position.SideToMove();
+		Square from = move.From();
+		Square to = move.To();
+		Bitboard enemies = position.Pieces(~us);
+		if (move.Type() == MoveType::CASTLING)
+		{
+			Square passed = Square((from + to) / 2);
+			for (Square square : { from, passed, to })
+			{
+				if (position.AttackersTo(square, position.Pieces()) & enemies)
+					return false;
+			}
+			return true;
+		}
+
+		Square captured = move.Type() == MoveType::EN_PASSANT ? to - PawnPush(us) : to;
+		Bitboard occupied = (position.Pieces() & ~SquareBB(from) & ~SquareBB(captured)) | SquareBB(to);
+		Square king = from == position.KingSquare(us) ? to : position.KingSquare(us);
+		return !(position.AttackersTo(king, occupied) & enemies & ~SquareBB(captured));
+	}
+
+	void AddValidatedMoves(const Position& position, const ValidatedPiece& piece, Bitboard targets, MoveList& moves)
+	{
+		bool pawn = TypeOf(position.PieceOn(piece.square)) == PAWN;
+		bool king = piece.square == position.KingSquare(piece.color);
+		while (targets)
+		{
+			Square to = PopLsb(targets);
+			MoveType type = MoveType::NORMAL;
+			if (pawn && to == position.EpSquare())
+				type = MoveType::EN_PASSANT;
+			else if (pawn && RelativeRank(piece.color, RankOf(to)) == RANK_8)
+				type = MoveType::PROMOTION;
+			else if (king && std::abs(FileOf(to) - FileOf(piece.square)) == 2)
+				type = MoveType::CASTLING;
+
+			if (!KeepsKingSafe(position, Move(piece.square, to, type)))
+				continue;
+			if (type == MoveType::PROMOTION)
+			{
+				for (PieceType promotion : { QUEEN, ROOK, BISHOP, KNIGHT })
+					moves.Add(Move(piece.square, to, type, promotion));
+			}
+			else
+			{
+				moves.Add(Move(piece.square, to, type));
+			}
+		}
+	}
+
+	void ValidatedMoves(const Position& position, const std::vector<ValidatedPiece>& pieces, MoveList& moves)
+	{
+		for (const ValidatedPiece& piece : pieces)
+		{
+			AddValidatedMoves(position, piece, piece.validator->GetValidSquares(piece.color, piece.square, position), moves);
+			AddValidatedMoves(position, piece, piece.finder->GetKillableSquares(piece.color, piece.square, position), moves);
+		}
+	}
+
+	std::vector<uint16_t> SortedMoves(const MoveList& moves)
+	{
+		std::vector<uint16_t> raw;
+		for (Move move : moves)
+			raw.push_back(move.Raw());
+		std::sort(raw.begin(), raw.end());
+		return raw;
+	}
+
+	// The legal moves of the bench positions, once from the former per-piece virtual validators
+	// and once from GenerateLegalMoves. Both must give the same moves before either is timed.
+	void BenchDispatch(int iterations)
+	{
+		std::vector<Position> positions(BenchFens.size());
+		std::vector<std::vector<ValidatedPiece>> validatedPieces(BenchFens.size());
+		for (size_t i = 0; i < BenchFens.size(); i++)
+		{
+			positions[i].SetFromFen(BenchFens[i]);
+			// Like the GUI, only the pieces of the side to move are asked.
+			Bitboard pieces = positions[i].Pieces(positions[i].SideToMove());
+			while (pieces)
+			{
+				Square square = PopLsb(pieces);
+				validatedPieces[i].emplace_back(positions[i].PieceOn(square), square);
+			}
+
+			MoveList validated, generated;
+			ValidatedMoves(positions[i], validatedPieces[i], validated);
+			GenerateLegalMoves(positions[i], generated);
+			if (SortedMoves(validated) != SortedMoves(generated))
+			{
+				std::printf("move mismatch: %d validated, %d generated in %s\n", validated.Size(), generated.Size(), BenchFens[i].c_str());
+				std::exit(1);
+			}
+		}
+
+		auto run = [&](const char* name, auto generate)
+		{
+			uint64_t sink = 0;
+			MoveList moves;
+			Clock::time_point start = Clock::now();
+			for (int n = 0; n < iterations; n++)
+			{
+				for (size_t i = 0; i < positions.size(); i++)
+				{
+					moves.Clear();
+					generate(i, moves);
+					sink += moves.Size();
+				}
+			}
+			double ms = MillisecondsSince(start);
+			std::printf("%-10s %10.1f ms %8.2f ns/position  (moves %llu)\n", name, ms, ms * 1e6 / (double(iterations) * positions.size()), (unsigned long long)sink);
+			return ms;
+		};
+
+		std::printf("dispatch: %zu positions, %d iterations\n", positions.size(), iterations);
+		double virtualMs = run("virtual", [&](size_t i, MoveList& moves)
+		{
+			ValidatedMoves(positions[i], validatedPieces[i], moves);
+		});
+		double generatorMs = run("generator", [&](size_t i, MoveList& moves)
+		{
+			GenerateLegalMoves(positions[i], moves);
+		});
+		std::printf("speedup    %10.2fx\n", virtualMs / generatorMs);
+	}
+
+	// Parallel search scaling: the same fixed-depth searches with 1, 2, 4, ... threads up to maxThreads,
+	// each from an empty table, in each SMP mode. nps should grow close to linearly for as long as there
+	// are cores for the threads; time to depth shows how much of that turns into search progress.
+	void BenchSmp(int maxThreads)
+	{
+		constexpr int Depth = 14;
+		constexpr size_t PositionCount = 4;
+		std::vector<Position> positions(PositionCount);
+		for (size_t i = 0; i < positions.size(); i++)
+			positions[i].SetFromFen(BenchFens[i * 2]);
+
+		std::unique_ptr<Search> search(new Search());
+		SearchLimits limits;
+		limits.depth = Depth;
+
+		std::printf("smp: %zu positions, depth %d, %u hardware threads\n", positions.size(), Depth, std::thread::hardware_concurrency());
+		const std::pair<SmpMode, const char*> modes[] = { { SmpMode::LAZY, "lazy" }, { SmpMode::ABDADA, "abdada" } };
+		for (const auto& [mode, modeName] : modes)
+		{
+			search->SetSmpMode(mode);
+			std::printf("%-7s %7s %12s %10s %12s %8s %8s\n", modeName, "threads", "nodes", "ms", "nps", "nps x", "ttd x");
+			double baseNps = 0;
+			double baseMs = 0;
+			for (int threads = 1; threads <= std::max(maxThreads, 1); threads *= 2)
+			{
+				search->SetThreads(threads);
+				uint64_t nodes = 0;
+				Clock::time_point start = Clock::now();
+				for (const Position& position : positions)
+				{
+					search->Clear();
+					nodes += search->Run(position, limits).nodes;
+				}
+				double ms = MillisecondsSince(start);
+				double nps = nodes * 1000.0 / std::max(ms, 1.0);
+				if (threads == 1)
+				{
+					baseNps = nps;
+					baseMs = ms;
+				}
+				std::printf("%-7s %7d %12llu %10.1f %12.0f %8.2f %8.2f\n", "", threads, (unsigned long long)nodes, ms, nps, nps / baseNps, baseMs / ms);
+			}
+		}
+	}
+
+	// Move ordering quality: single-threaded fixed-depth searches with the quiet move heuristics
+	// switched on one at a time. Good ordering shows as a high share of cutoffs on the first move
+	// and a low effective branching factor, here the growth in nodes per iteration over the last four.
+	void BenchOrdering(int depth)
+	{
+		constexpr size_t PositionCount = 4;
+		constexpr int EbfIterations = 4;
+		std::vector<Position> positions(PositionCount);
+		for (size_t i = 0; i < positions.size(); i++)
+			positions[i].SetFromFen(BenchFens[i * 2]);
+		depth = std::max(depth, EbfIterations + 1);
+
+		SearchFeatures none;
+		none.killers = none.history = none.counterMoves = none.continuationHistory = false;
+		SearchFeatures withKillers = none;
+		withKillers.killers = true;
+		SearchFeatures withHistory = withKillers;
+		withHistory.history = true;
+		SearchFeatures withCounterMoves = withHistory;
+		withCounterMoves.counterMoves = true;
+		SearchFeatures all = withCounterMoves;
+		all.continuationHistory = true;
+		const std::pair<SearchFeatures, const char*> configurations[] =
+		{
+			{ none, "mvv-lva" }, { withKillers, "+killers" }, { withHistory, "+history" },
+			{ withCounterMoves, "+counter" }, { all, "+conthist" }
+		};
+
+		std::unique_ptr<Search> search(new Search());
+		SearchLimits limits;
+		limits.depth = depth;
+
+		std::printf("ordering: %zu positions, depth %d\n", positions.size(), depth);
+		std::printf("%-10s %12s %10s %10s %8s\n", "", "nodes", "ms", "first cut", "ebf");
+		for (const auto& [features, name] : configurations)
+		{
+			search->SetFeatures(features);
+			uint64_t nodes = 0;
+			uint64_t cutoffs = 0;
+			uint64_t firstMoveCutoffs = 0;
+			double ebf = 0;
+			Clock::time_point start = Clock::now();
+			for (const Position& position : positions)
+			{
+				search->Clear();
+				std::vector<uint64_t> iterationNodes;
+				uint64_t previous = 0;
+				SearchInfo info = search->Run(position, limits, [&](const SearchInfo& iteration)
+				{
+					iterationNodes.push_back(iteration.nodes - previous);
+					previous = iteration.nodes;
+				});
+				nodes += info.nodes;
+				cutoffs += info.cutoffs;
+				firstMoveCutoffs += info.firstMoveCutoffs;
+				size_t last = iterationNodes.size() - 1;
+				ebf += std::pow(double(iterationNodes[last]) / double(iterationNodes[last - EbfIterations]), 1.0 / EbfIterations);
+			}
+			double ms = MillisecondsSince(start);
+			std::printf("%-10s %12llu %10.1f %9.1f%% %8.2f\n", name, (unsigned long long)nodes, ms,
+				100.0 * double(firstMoveCutoffs) / double(std::max<uint64_t>(cutoffs, 1)), ebf / double(positions.size()));
+		}
+	}
+
+	// Selective search: single-threaded fixed-depth searches with no pruning or reductions, with
+	// each technique alone, and with all of them, reporting nodes and time to depth.
+	void BenchSelective(int depth)
+	{
+		constexpr size_t PositionCount = 4;
+		std::vector<Position> positions(PositionCount);
+		for (size_t i = 0; i < positions.size(); i++)
+			positions[i].SetFromFen(BenchFens[i * 2]);
+
+		SearchFeatures none;
+		none.nullMove = none.lateMoveReductions = none.reverseFutility = none.futility = none.lateMovePruning = none.razoring = false;
+		const std::pair<bool SearchFeatures::*, const char*> techniques[] =
+		{
+			{ &SearchFeatures::nullMove, "null move" }, { &SearchFeatures::lateMoveReductions, "lmr" },
+			{ &SearchFeatures::reverseFutility, "rev futil" }, { &SearchFeatures::futility, "futility" },
+			{ &SearchFeatures::lateMovePruning, "lmp" }, { &SearchFeatures::razoring, "razoring" }
+		};
+		std::vector<std::pair<SearchFeatures, const char*>> configurations = { { none, "none" } };
+		for (const auto& [flag, name] : techniques)
+		{
+			SearchFeatures features = none;
+			features.*flag = true;
+			configurations.push_back({ features, name });
+		}
+		configurations.push_back({ SearchFeatures(), "all" });
+
+		std::unique_ptr<Search> search(new Search());
+		SearchLimits limits;
+		limits.depth = depth;
+
+		std::printf("selective: %zu positions, depth %d\n", positions.size(), depth);
+		std::printf("%-10s %12s %10s %10s %10s\n", "", "nodes", "ms", "nodes x", "ttd x");
+		uint64_t baseNodes = 0;
+		double baseMs = 0;
+		for (const auto& [features, name] : configurations)
+		{
+			search->SetFeatures(features);
+			uint64_t nodes = 0;
+			Clock::time_point start = Clock::now();
+			for (const Position& position : positions)
+			{
+				search->Clear();
+				nodes += search->Run(position, limits).nodes;
+			}
+			double ms = MillisecondsSince(start);
+			if (baseNodes == 0)
+			{
+				baseNodes = nodes;
+				baseMs = ms;
+			}
+			std::printf("%-10s %12llu %10.1f %10.2f %10.2f\n", name, (unsigned long long)nodes, ms, double(baseNodes) / double(nodes), baseMs / ms);
+		}
+	}
+
+	struct Bench
+	{
+		const char* name;
+		void (*run)(int iterations);
+		int defaultIterations;
+	};
+
+	const Bench Benches[] =
+	{
+		{ "sliders", BenchSliders, 100000 },
+		{ "pext", BenchPext, 100000 },
+		{ "dispatch", BenchDispatch, 200000 },
+		// The argument is the largest thread count.
+		{ "smp", BenchSmp, 64 },
+		// The argument is the search depth.
+		{ "ordering", BenchOrdering, 12 },
+		// The argument is the search depth.
+		{ "selective", BenchSelective, 8 }
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	InitBitboards();
+	InitZobrist();
+
+	const char* name = argc > 1 ? argv[1] : nullptr;
+	bool found = false;
+	for (const Bench& bench : Benches)
+	{
+		if (name == nullptr || std::strcmp(name, bench.name) == 0)
+		{
+			bench.run(argc > 2 ? std::atoi(argv[2]) : bench.defaultIterations);
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		std::printf("usage: Bench [name [iterations]]\nbenches:");
+		for (const Bench& bench : Benches)
+			std::printf(" %s", bench.name);
+		std::printf("\n");
+		return 1;
+	}
+	return 0;
+}
@@ -1,3 +1,9 @@
+#include <algorithm>
+#include "ChessClock.h"
+#include "EngineWorker.h"
+#include "MoveGen.h"
+#include "Position.h"
+
 #define OLC_PGE_APPLICATION
 #pragma warning(push)
 #pragma warning(disable: 26812) 
@@ -45,8 +51,14 @@ public:
 
 };
 
-struct MovementValidator;
-struct KillableFinder;
+// Where a piece can go, tagged by whether it lands on an empty square or takes an enemy piece,
+// and captures by whether they still lose material once all recaptures are played out.
+struct MoveTargets
+{
+	Bitboard quiets = 0;
+	Bitboard captures = 0;
+	Bitboard losingCaptures = 0;
+};
 
 class Piece
 {
@@ -68,9 +80,9 @@ public:
 	};
 
 public:
-	Piece(const olc::vf2d& position, Color color, MovementValidator* validator, KillableFinder* killableFinder);
+	Piece(const olc::vf2d& position, Color color);
 
-	virtual ~Piece();
+	virtual ~Piece() = default;
 
 public:
 	olc::vf2d position;
@@ -81,9 +93,6 @@ public:
 		return color;
 	}
 
-	std::vector<olc::vi2d> GetValidSquares(const std::vector<Piece*>& pieces, const olc::vf2d& position, const Board& board) const;
-	std::vector<Piece*> GetKillablePieces(const std::vector<Piece*>& pieces, const Piece& currentGrabbed, const olc::vf2d& position, const Board& board) const;
-
 	bool operator==(const Piece& other)
 	{
 		return this == &other;
@@ -92,10 +101,6 @@ public:
 private:
 	Color color;
 
-protected:
-	MovementValidator* movementValidator;
-	KillableFinder* killableFinder;
-
 };
 
 class Pawn : public Piece
@@ -180,6 +185,16 @@ olc::vf2d squareToScreen(const olc::vi2d square, const Board& board)
 	return (olc::vf2d)(square * board.squareSize);
 }
 
+Square gridToSquare(const olc::vi2d& grid)
+{
+	return MakeSquare(File(grid.x), Rank(7 - grid.y));
+}
+
+olc::vi2d squareToGrid(Square square)
+{
+	return { FileOf(square), 7 - RankOf(square) };
+}
+
 Piece* getPieceInSquare(const olc::vi2d& square, const std::vector<Piece*> pieces, const Board& board)
 {
 	for (auto& piece : pieces)
@@ -192,539 +207,78 @@ Piece* getPieceInSquare(const olc::vi2d& square, const std::vector<Piece*> piece
 	return nullptr;
 }
 
-struct MovementValidator
+Piece::Piece(const olc::vf2d& position, Color color) :
+	position{ position }, color{ color }
 {
-	std::vector<olc::vi2d> GetOccupiableSquares(const std::vector<Piece*>& pieces, const olc::vf2d& position, const Piece& pawn, const Board& board)
-	{
-		std::vector<olc::vi2d> validSquares = GetValidSquares(pawn, position, board, pieces);
-		validSquares.push_back(position);
-		for (auto& piece : pieces)
-		{
-			if (!(*piece == pawn))
-			{
-				for (auto& validSquare : validSquares)
-				{
-					if (screenToSquare(piece->position, board) == validSquare)
-					{
-						validSquares.erase(std::remove(validSquares.begin(), validSquares.end(), validSquare), validSquares.end());
-					}
-
-					if (validSquare.x < 0 || validSquare.x > 7 || validSquare.y < 0 || validSquare.y > 7)
-					{
-						validSquares.erase(std::remove(validSquares.begin(), validSquares.end(), validSquare), validSquares.end());
-					}
-				}
-			}
-		}
-		return validSquares;
-	}
-	virtual ~MovementValidator() = default;
-
-protected:
-	virtual std::vector<olc::vi2d> GetValidSquares(const Piece&, const olc::vf2d&, const Board&, const std::vector<Piece*>&) = 0;
-};
+}
 
-struct PawnMovementValidator : public MovementValidator
-{
-	std::vector<olc::vi2d> GetValidSquares(const Piece& pawn, const olc::vf2d& position, const Board& board, const std::vector<Piece*>&) override
-	{
-		std::vector<olc::vi2d> outValidSquares;
-		if (pawn.GetColor() == Piece::Color::BLACK)
-		{
-			outValidSquares.push_back(screenToSquare(position, board) + olc::vi2d{ 0, 1 });
-		}
+// Taken from the same legal moves ValidateMovement accepts, so a piece is highlighted exactly
+// where dropping it plays a move: castling, double pushes and en passant included, moves that
+// would leave the king in check not.
+MoveTargets GetMoveTargets(const Position& position, Square from)
+{
+	MoveTargets targets;
+	MoveList moves;
+	GenerateLegalMoves(position, moves);
+	for (Move move : moves)
+	{
+		if (move.From() != from)
+			continue;
+		if (!position.IsCapture(move))
+			targets.quiets |= SquareBB(move.To());
+		else if (position.See(move, 0))
+			targets.captures |= SquareBB(move.To());
 		else
-		{
-			outValidSquares.push_back(screenToSquare(position, board) + olc::vi2d{ 0, -1 });
-		}
-
-		return outValidSquares;
-	}
-};
-
-struct KingMovementValidator : public MovementValidator
-{
-	std::vector<olc::vi2d> GetValidSquares(const Piece&, const olc::vf2d& position, const Board& board, const std::vector<Piece*>&) override
-	{
-		std::vector<olc::vi2d> outValidSquares;
-
-		outValidSquares.push_back(screenToSquare(position, board) + olc::vi2d{ 0, 1 });
-		outValidSquares.push_back(screenToSquare(position, board) + olc::vi2d{ 0, -1 });
-		outValidSquares.push_back(screenToSquare(position, board) + olc::vi2d{ 1, 0 });
-		outValidSquares.push_back(screenToSquare(position, board) + olc::vi2d{ -1, 0 });
-
-		return outValidSquares;
+			targets.losingCaptures |= SquareBB(move.To());
 	}
-};
-
-struct QueenMovementValidator : public MovementValidator
-{
-	std::vector<olc::vi2d> GetValidSquares(const Piece& queen, const olc::vf2d& position, const Board& board, const std::vector<Piece*>& pieces) override
-	{
-		std::vector<olc::vi2d> outValidSquares;
-
-		auto addSquare = [&](olc::vi2d dir)
-		{
-			olc::vi2d current = screenToSquare(position, board);
-			for (int i = 0; i < 8; i++)
-			{
-				current += dir;
-				for (auto& piece : pieces)
-				{
-					if (!(*piece == queen))
-					{
-						if (current == screenToSquare(piece->position, board))
-							return;
-					}
-				}
-				outValidSquares.push_back(current);
-			}
-		};
-
-		addSquare({ 1, 1 }); addSquare({ -1, -1 });
-		addSquare({ 1, -1 }); addSquare({ -1, 1 });
-		addSquare({ 0, -1 }); addSquare({ 0, 1 });
-		addSquare({ 1, 0 }); addSquare({ -1, 0 });
-		return outValidSquares;
-	}
-};
-
-struct RookMovementValidator : public MovementValidator
-{
-	std::vector<olc::vi2d> GetValidSquares(const Piece& queen, const olc::vf2d& position, const Board& board, const std::vector<Piece*>& pieces) override
-	{
-		std::vector<olc::vi2d> outValidSquares;
-
-		auto addSquare = [&](olc::vi2d dir)
-		{
-			olc::vi2d current = screenToSquare(position, board);
-			for (int i = 0; i < 8; i++)
-			{
-				current += dir;
-				for (auto& piece : pieces)
-				{
-					if (!(*piece == queen))
-					{
-						if (current == screenToSquare(piece->position, board))
-							return;
-					}
-				}
-				outValidSquares.push_back(current);
-			}
-		};
-
-		addSquare({ 0, -1 }); addSquare({ 0, 1 });
-		addSquare({ 1, 0 }); addSquare({ -1, 0 });
-		return outValidSquares;
-	}
-};
-
-struct BishopMovementValidator : public MovementValidator
-{
-	std::vector<olc::vi2d> GetValidSquares(const Piece& queen, const olc::vf2d& position, const Board& board, const std::vector<Piece*>& pieces) override
-	{
-		std::vector<olc::vi2d> outValidSquares;
-
-		auto addSquare = [&](olc::vi2d dir)
-		{
-			olc::vi2d current = screenToSquare(position, board);
-			for (int i = 0; i < 8; i++)
-			{
-				current += dir;
-				for (auto& piece : pieces)
-				{
-					if (!(*piece == queen))
-					{
-						if (current == screenToSquare(piece->position, board))
-							return;
-					}
-				}
-				outValidSquares.push_back(current);
-			}
-		};
-
-		addSquare({ 1, 1 }); addSquare({ -1, -1 });
-		addSquare({ 1, -1 }); addSquare({ -1, 1 });
-		return outValidSquares;
-	}
-};
-
-struct KnightMovementValidator : public MovementValidator
-{
-	std::vector<olc::vi2d> GetValidSquares(const Piece& queen, const olc::vf2d& position, const Board& board, const std::vector<Piece*>& pieces) override
-	{
-		std::vector<olc::vi2d> outValidSquares;
-
-		auto addSquareInX = [&](int x)
-		{
-			outValidSquares.push_back(screenToSquare(position, board) + olc::vi2d{ x, -1 });
-			outValidSquares.push_back(screenToSquare(position, board) + olc::vi2d{ x, 1 });
-		};
-
-		auto addSquareInY = [&](int y)
-		{
-			outValidSquares.push_back(screenToSquare(position, board) + olc::vi2d{ -1, y });
-			outValidSquares.push_back(screenToSquare(position, board) + olc::vi2d{ 1, y });
-		};
-
-		addSquareInX(2); addSquareInX(-2);
-		addSquareInY(2); addSquareInY(-2);
-		return outValidSquares;
-	}
-};
-
-struct KillableFinder
-{
-	virtual std::vector<Piece*> FindAndReturn(const std::vector<Piece*>&, const Piece&, const olc::vf2d&, const Board&) = 0;
-};
-
-struct PawnKillableFinder : public KillableFinder
-{
-	std::vector<Piece*> FindAndReturn(const std::vector<Piece*>& pieces, const Piece& currentGrabbed, const olc::vf2d& position, const Board& board) override
-	{
-		std::vector<Piece*> out;
-		auto addKillables = [&](const Piece::Color killer, const Piece::Color target, int upordown)
-		{
-			if (currentGrabbed.GetColor() == killer)
-			{
-				for (auto& piece : pieces)
-				{
-					if (piece->GetColor() == target)
-					{
-						if (screenToSquare(piece->position, board) == screenToSquare(position, board) + olc::vi2d{ -1, upordown })
-						{
-							out.push_back(piece);
-						}
-						if (screenToSquare(piece->position, board) == screenToSquare(position, board) + olc::vi2d{ 1, upordown })
-						{
-							out.push_back(piece);
-						}
-					}
-				}
-			}
-		};
-
-		if (currentGrabbed.GetColor() == Piece::Color::BLACK)
-		{
-			addKillables(Piece::Color::BLACK, Piece::Color::WHITE, 1);
-		}
-		else if (currentGrabbed.GetColor() == Piece::Color::WHITE)
-		{
-			addKillables(Piece::Color::WHITE, Piece::Color::BLACK, -1);
-		}
-
-		return out;
-	}
-};
-
-struct KingKillableFinder : public KillableFinder
-{
-	std::vector<Piece*> FindAndReturn(const std::vector<Piece*>& pieces, const Piece& currentGrabbed, const olc::vf2d& position, const Board& board) override
-	{
-		std::vector<Piece*> out;
-		auto addKillables = [&](const Piece::Color killer, const Piece::Color target)
-		{
-			if (currentGrabbed.GetColor() == killer)
-			{
-				for (auto& piece : pieces)
-				{
-					if (piece->GetColor() == target)
-					{
-						if (screenToSquare(piece->position, board) == screenToSquare(position, board) + olc::vi2d{ -1, 0 }) out.push_back(piece);
-						if (screenToSquare(piece->position, board) == screenToSquare(position, board) + olc::vi2d{ 1, 0 }) out.push_back(piece);
-						if (screenToSquare(piece->position, board) == screenToSquare(position, board) + olc::vi2d{ 0, 1 }) out.push_back(piece);
-						if (screenToSquare(piece->position, board) == screenToSquare(position, board) + olc::vi2d{ 0, -1 }) out.push_back(piece);
-					}
-				}
-			}
-		};
-
-		if (currentGrabbed.GetColor() == Piece::Color::BLACK)
-		{
-			addKillables(Piece::Color::BLACK, Piece::Color::WHITE);
-		}
-		else if (currentGrabbed.GetColor() == Piece::Color::WHITE)
-		{
-			addKillables(Piece::Color::WHITE, Piece::Color::BLACK);
-		}
-		return out;
-	}
-};
-
-struct KnightKillableFinder : public KillableFinder
-{
-	std::vector<Piece*> FindAndReturn(const std::vector<Piece*>& pieces, const Piece& currentGrabbed, const olc::vf2d& position, const Board& board) override
-	{
-		std::vector<Piece*> out;
-		auto addKillables = [&](const Piece::Color killer, const Piece::Color target)
-		{
-			if (currentGrabbed.GetColor() == killer)
-			{
-				for (auto& piece : pieces)
-				{
-					if (piece->GetColor() == target)
-					{
-						int possibleX[8] = { 2, 1, -1, -2, -2, -1, 1, 2 };
-						int possibleY[8] = { 1, 2, 2, 1, -1, -2, -2, -1 };
-
-						for (int i = 0; i < 8; i++)
-						{
-							if (screenToSquare(piece->position, board) == screenToSquare(position, board) + olc::vi2d{ possibleX[i], possibleY[i] }) 
-								out.push_back(piece);
-						}
-					}
-				}
-			}
-		};
-
-		if (currentGrabbed.GetColor() == Piece::Color::BLACK)
-		{
-			addKillables(Piece::Color::BLACK, Piece::Color::WHITE);
-		}
-		else if (currentGrabbed.GetColor() == Piece::Color::WHITE)
-		{
-			addKillables(Piece::Color::WHITE, Piece::Color::BLACK);
-		}
-		return out;
-	}
-};
-
-struct RookKillableFinder : public KillableFinder
-{
-	std::vector<Piece*> FindAndReturn(const std::vector<Piece*>& pieces, const Piece& currentGrabbed, const olc::vf2d& position, const Board& board) override
-	{
-		std::vector<Piece*> out;
-		olc::vi2d currentSquare = screenToSquare(position, board);
-		auto addKillables = [&](olc::vi2d direction, double magnitude, const Piece::Color killer, const Piece::Color target)
-		{
-			olc::vf2d current = currentSquare;
-			for (int i = 0; i < std::round(magnitude); i++)
-			{
-				current += direction;
-				if (currentGrabbed.GetColor() == killer)
-				{
-					for (auto& piece : pieces)
-					{
-						if (screenToSquare(piece->position, board) == current)
-						{
-							if (piece->GetColor() == target)
-							{
-								out.push_back(piece);
-								return;
-							}
-							return;
-						}
-						
-					}
-				}
-				
-			}
-		};
-
-		if (currentGrabbed.GetColor() == Piece::Color::WHITE)
-		{
-			addKillables({ 0, 1 }, (double)board.squareSize.y - currentSquare.y, Piece::Color::WHITE, Piece::Color::BLACK);
-			addKillables({ 0, -1 },(double)currentSquare.y, Piece::Color::WHITE, Piece::Color::BLACK);
-			addKillables({ 1, 0 }, (double)board.squareSize.x - currentSquare.x, Piece::Color::WHITE, Piece::Color::BLACK);
-			addKillables({ -1, 0 },(double)currentSquare.x, Piece::Color::WHITE, Piece::Color::BLACK);
-		}
-		else if (currentGrabbed.GetColor() == Piece::Color::BLACK)
-		{
-			addKillables({ 0, 1 }, (double)board.squareSize.y - currentSquare.y, Piece::Color::BLACK, Piece::Color::WHITE);
-			addKillables({ 0, -1 }, (double)currentSquare.y, Piece::Color::BLACK, Piece::Color::WHITE);
-			addKillables({ 1, 0 }, (double)board.squareSize.x - currentSquare.x, Piece::Color::BLACK, Piece::Color::WHITE);
-			addKillables({ -1, 0 }, (double)currentSquare.x, Piece::Color::BLACK, Piece::Color::WHITE);
-		}
-		
-		return out;
-	}
-};
-
-struct BishopKillableFinder : public KillableFinder
-{
-	std::vector<Piece*> FindAndReturn(const std::vector<Piece*>& pieces, const Piece& currentGrabbed, const olc::vf2d& position, const Board& board) override
-	{
-		std::vector<Piece*> out;
-		olc::vi2d currentSquare = screenToSquare(position, board);
-		auto addKillables = [&](olc::vi2d direction, double magnitude, const Piece::Color killer, const Piece::Color target)
-		{
-			olc::vf2d current = currentSquare;
-			for (int i = 0; i < std::round(magnitude); i++)
-			{
-				current += direction;
-				if (currentGrabbed.GetColor() == killer)
-				{
-					for (auto& piece : pieces)
-					{
-						if (screenToSquare(piece->position, board) == current)
-						{
-							if (piece->GetColor() == target)
-							{
-								out.push_back(piece);
-								return;
-							}
-							return;
-						}
-
-					}
-				}
-			}
-		};
-
-		if (currentGrabbed.GetColor() == Piece::Color::WHITE)
-		{
-			double mag = std::hypot(currentSquare.x * -1, currentSquare.y * -1);
-			addKillables({ -1, -1 }, mag, Piece::Color::WHITE, Piece::Color::BLACK);
-
-			mag = std::hypot(board.nSquares.x - currentSquare.x, board.nSquares.y - currentSquare.y);
-			addKillables({ 1, 1 }, mag, Piece::Color::WHITE, Piece::Color::BLACK);
-
-			mag = std::hypot(board.nSquares.x - currentSquare.x, currentSquare.y * -1);
-			addKillables({ 1, -1 }, mag, Piece::Color::WHITE, Piece::Color::BLACK);
-
-			mag = std::hypot(currentSquare.x * - 1, board.nSquares.y - currentSquare.y);
-			addKillables({ -1, 1 }, mag, Piece::Color::WHITE, Piece::Color::BLACK);
-		}
-		else if (currentGrabbed.GetColor() == Piece::Color::BLACK)
-		{
-			double mag = std::hypot(currentSquare.x * -1, currentSquare.y * -1);
-			addKillables({ -1, -1 }, mag, Piece::Color::BLACK, Piece::Color::WHITE);
-
-			mag = std::hypot(board.nSquares.x - currentSquare.x, board.nSquares.y - currentSquare.y);
-			addKillables({ 1, 1 }, mag, Piece::Color::BLACK, Piece::Color::WHITE);
-
-			mag = std::hypot(board.nSquares.x - currentSquare.x, currentSquare.y * -1);
-			addKillables({ 1, -1 }, mag, Piece::Color::BLACK, Piece::Color::WHITE);
-
-			mag = std::hypot(currentSquare.x * -1, board.nSquares.y - currentSquare.y);
-			addKillables({ -1, 1 }, mag, Piece::Color::BLACK, Piece::Color::WHITE);
-		}
-
-		return out;
-	}
-};
-
-struct QueenKillableFinder : public KillableFinder
-{
-	std::vector<Piece*> FindAndReturn(const std::vector<Piece*>& pieces, const Piece& currentGrabbed, const olc::vf2d& position, const Board& board) override
-	{
-		std::vector<Piece*> out;
-		olc::vi2d currentSquare = screenToSquare(position, board);
-		auto addKillables = [&](olc::vi2d direction, double magnitude, const Piece::Color killer, const Piece::Color target)
-		{
-			olc::vf2d current = currentSquare;
-			for (int i = 0; i < std::round(magnitude); i++)
-			{
-				current += direction;
-				if (currentGrabbed.GetColor() == killer)
-				{
-					for (auto& piece : pieces)
-					{
-						if (screenToSquare(piece->position, board) == current)
-						{
-							if (piece->GetColor() == target)
-							{
-								out.push_back(piece);
-								return;
-							}
-							return;
-						}
-
-					}
-				}
-			}
-		};
-
-		if (currentGrabbed.GetColor() == Piece::Color::WHITE)
-		{
-			addKillables({ 0, 1 }, (double)board.squareSize.y - currentSquare.y, Piece::Color::WHITE, Piece::Color::BLACK);
-			addKillables({ 0, -1 }, (double)currentSquare.y, Piece::Color::WHITE, Piece::Color::BLACK);
-			addKillables({ 1, 0 }, (double)board.squareSize.x - currentSquare.x, Piece::Color::WHITE, Piece::Color::BLACK);
-			addKillables({ -1, 0 }, (double)currentSquare.x, Piece::Color::WHITE, Piece::Color::BLACK);
-
-			double mag = std::hypot(currentSquare.x * -1, currentSquare.y * -1);
-			addKillables({ -1, -1 }, mag, Piece::Color::WHITE, Piece::Color::BLACK);
-
-			mag = std::hypot(board.nSquares.x - currentSquare.x, board.nSquares.y - currentSquare.y);
-			addKillables({ 1, 1 }, mag, Piece::Color::WHITE, Piece::Color::BLACK);
-
-			mag = std::hypot(board.nSquares.x - currentSquare.x, currentSquare.y * -1);
-			addKillables({ 1, -1 }, mag, Piece::Color::WHITE, Piece::Color::BLACK);
-
-			mag = std::hypot(currentSquare.x * -1, board.nSquares.y - currentSquare.y);
-			addKillables({ -1, 1 }, mag, Piece::Color::WHITE, Piece::Color::BLACK);
-		}
-		else if (currentGrabbed.GetColor() == Piece::Color::BLACK)
-		{
-			addKillables({ 0, 1 }, (double)board.squareSize.y - currentSquare.y, Piece::Color::BLACK, Piece::Color::WHITE);
-			addKillables({ 0, -1 }, (double)currentSquare.y, Piece::Color::BLACK, Piece::Color::WHITE);
-			addKillables({ 1, 0 }, (double)board.squareSize.x - currentSquare.x, Piece::Color::BLACK, Piece::Color::WHITE);
-			addKillables({ -1, 0 }, (double)currentSquare.x, Piece::Color::BLACK, Piece::Color::WHITE);
-
-			double mag = std::hypot(currentSquare.x * -1, currentSquare.y * -1);
-			addKillables({ -1, -1 }, mag, Piece::Color::BLACK, Piece::Color::WHITE);
-
-			mag = std::hypot(board.nSquares.x - currentSquare.x, board.nSquares.y - currentSquare.y);
-			addKillables({ 1, 1 }, mag, Piece::Color::BLACK, Piece::Color::WHITE);
-
-			mag = std::hypot(board.nSquares.x - currentSquare.x, currentSquare.y * -1);
-			addKillables({ 1, -1 }, mag, Piece::Color::BLACK, Piece::Color::WHITE);
-
-			mag = std::hypot(currentSquare.x * -1, board.nSquares.y - currentSquare.y);
-			addKillables({ -1, 1 }, mag, Piece::Color::BLACK, Piece::Color::WHITE);
-		}
-
-		return out;
-	}
-};
-
-Piece::Piece(const olc::vf2d& position, Color color, MovementValidator* validator, KillableFinder* killableFinder) :
-	position{ position }, color{ color }, movementValidator{ validator }, killableFinder{ killableFinder }
-{
-}
-
-Piece::~Piece() { delete movementValidator; delete killableFinder; };
-
-std::vector<olc::vi2d> Piece::GetValidSquares(const std::vector<Piece*>& pieces, const olc::vf2d& position, const Board& board) const
-{
-	return movementValidator->GetOccupiableSquares(pieces, position, *this, board);
-}
-
-std::vector<Piece*> Piece::GetKillablePieces(const std::vector<Piece*>& pieces, const Piece& currentGrabbed, const olc::vf2d& position, const Board& board) const
-{
-	return killableFinder->FindAndReturn(pieces, currentGrabbed, position, board);
+	return targets;
 }
 
 Pawn::Pawn(const olc::vf2d& position, Color color) :
-	Piece{ position, color, new PawnMovementValidator{}, new PawnKillableFinder{} }
+	Piece{ position, color }
 {
 }
 
 King::King(const olc::vf2d& position, Color color) :
-	Piece{ position, color, new KingMovementValidator{}, new KingKillableFinder{} }
+	Piece{ position, color }
 {
 }
 
 Queen::Queen(const olc::vf2d& position, Color color) :
-	Piece{ position, color, new QueenMovementValidator{}, new QueenKillableFinder{} }
+	Piece{ position, color }
 {
 }
 
 Rook::Rook(const olc::vf2d& position, Color color) :
-	Piece{ position, color, new RookMovementValidator{}, new RookKillableFinder{} }
+	Piece{ position, color }
 {
 }
 
 Bishop::Bishop(const olc::vf2d& position, Color color) :
-	Piece{ position, color, new BishopMovementValidator{}, new BishopKillableFinder{} }
+	Piece{ position, color }
 {
 }
 
 Knight::Knight(const olc::vf2d& position, Color color) :
-	Piece{ position, color, new KnightMovementValidator{}, new KnightKillableFinder{} }
+	Piece{ position, color }
 {
 }
 
+Piece* createPiece(PieceCode code, const olc::vf2d& position)
+{
+	Piece::Color color = ColorOf(code) == WHITE ? Piece::Color::WHITE : Piece::Color::BLACK;
+	switch (TypeOf(code))
+	{
+	case PAWN: return new Pawn{ position, color };
+	case KNIGHT: return new Knight{ position, color };
+	case BISHOP: return new Bishop{ position, color };
+	case ROOK: return new Rook{ position, color };
+	case QUEEN: return new Queen{ position, color };
+	case KING: return new King{ position, color };
+	default: return nullptr;
+	}
+}
+
 class Controller
 {
 public:
@@ -744,28 +298,10 @@ public:
 		}
 	}
 
-	double UpdateTurn(olc::PixelGameEngine* const pge, double eachTurnTime, bool returned, State& state)
+	// The side to move is the position's, so the turn passes only when a move has been made.
+	void UpdateTurn(Color sideToMove)
 	{
-		std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
-		std::chrono::duration<double> elapsedTime = std::chrono::duration_cast<std::chrono::duration<double>>(now - startTime);
-
-		if (elapsedTime.count() > eachTurnTime)
-		{
-			startTime = now;
-			turnControl = !turnControl;
-		}
-
-		if (pge->GetMouse(0).bReleased)
-		{
-			if (lastGrabbedPiece != nullptr && grabbedPiece == nullptr && !returned)
-			{
-				startTime = now;
-				turnControl = !turnControl;
-			}
-		}
-
-		turn = turnControl ? Turn::BLACK : Turn::WHITE;
-		return elapsedTime.count();
+		turn = sideToMove == BLACK ? Turn::BLACK : Turn::WHITE;
 	}
 
 	Piece* GetGrabbedPiece() const
@@ -787,6 +323,13 @@ public:
 		return nullptr;
 	}
 
+	// The pieces are rebuilt after every move, so pointers into the old ones must be dropped.
+	void ForgetPieces()
+	{
+		grabbedPiece = nullptr;
+		lastGrabbedPiece = nullptr;
+	}
+
 	std::string CurrentTurn()
 	{
 		if (turn == Turn::BLACK) return "Black"; else return "White";
@@ -867,32 +410,34 @@ private:
 	};
 
 private:
-	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
 	const olc::PixelGameEngine* const pge;
 	Piece* grabbedPiece = nullptr;
 	Piece* lastGrabbedPiece = nullptr;
 	olc::vf2d lastPosition{};
 	Turn turn = Turn::WHITE;
-	bool turnControl = true;
 	bool moving = true;
 };
 
-bool ValidateMovement(olc::PixelGameEngine* pge, const std::vector<Piece*>& pieces, const olc::vf2d& lastPosition, Piece& piece, const Board& board)
+bool ValidateMovement(olc::PixelGameEngine* pge, Position& position, const olc::vf2d& lastPosition, Piece& piece, const Board& board)
 {
 	if (pge->GetMouse(0).bReleased)
 	{
-		bool notReturn = false;
-		std::vector<olc::vi2d> squares = piece.GetValidSquares(pieces, lastPosition, board);
-		for (auto& square : squares)
+		Square from = gridToSquare(screenToSquare(lastPosition, board));
+		olc::vi2d to = screenToSquare(piece.position, board);
+		MoveList legalMoves;
+		GenerateLegalMoves(position, legalMoves);
+		for (Move move : legalMoves)
 		{
-			notReturn |= screenToSquare(piece.position, board) == square;
+			// There is no promotion picker, pawns always promote to a queen.
+			if (move.From() == from && squareToGrid(move.To()) == to && (move.Type() != MoveType::PROMOTION || move.Promotion() == QUEEN))
+			{
+				position.MakeMove(move);
+				return false;
+			}
 		}
 
-		if (squares.empty() || !notReturn)
-		{
-			piece.position = lastPosition;
-			return true;
-		}
+		piece.position = lastPosition;
+		return true;
 	}
 
 	return false;
@@ -954,26 +499,66 @@ void RenderPiece(olc::PixelGameEngine* pge, const Board& board, const Piece& pie
 	}
 }
 
-void DrawOccupiableSquares(olc::PixelGameEngine* pge, const std::vector<Piece*>& pieces, const olc::vf2d& lastPosition, const Board& board, const Piece& piece)
+void FillSquares(olc::PixelGameEngine* pge, const Board& board, Bitboard squares, const olc::Pixel& color)
 {
+	while (squares)
+	{
+		pge->FillRectDecal(squareToScreen(squareToGrid(PopLsb(squares)), board), board.squareSize, color);
+	}
+}
 
-	std::vector<olc::vi2d> squares = piece.GetValidSquares(pieces, lastPosition, board);
+// Occupiable squares in green and killable pieces in red, from a single query of the grabbed piece.
+// Captures that lose material once all recaptures are played out are drawn in orange instead.
+void DrawMoveTargets(olc::PixelGameEngine* pge, const Position& position, const olc::vf2d& lastPosition, const Board& board)
+{
+	MoveTargets targets = GetMoveTargets(position, gridToSquare(screenToSquare(lastPosition, board)));
+	FillSquares(pge, board, targets.quiets, olc::Pixel{ 100, 250, 100, 80 });
+	FillSquares(pge, board, targets.captures, olc::Pixel{ 250, 100, 100, 80 });
+	FillSquares(pge, board, targets.losingCaptures, olc::Pixel{ 250, 170, 60, 80 });
+}
 
-	for (auto& square : squares)
+// Black's clock at the top of the board and White's at the bottom, the running one in red.
+void DrawClocks(olc::PixelGameEngine* pge, const ChessClock& clock)
+{
+	auto DrawClock = [&](Color side, const olc::vf2d& position)
 	{
-		pge->FillRectDecal(squareToScreen(square, board), board.squareSize, olc::Pixel{ 100, 250, 100, 80 });
-	}
+		std::string text = (side == WHITE ? "White " : "Black ") + FormatClockTime(clock.Remaining(side));
+		bool ticking = clock.Running() && clock.SideRunning() == side;
+		pge->DrawStringDecal(position, text, ticking ? olc::RED : olc::YELLOW, { 1.5f, 1.5f });
+	};
+
+	DrawClock(BLACK, { 5.0f, 5.0f });
+	DrawClock(WHITE, { 5.0f, float(pge->ScreenHeight()) - 17.0f });
 }
 
-void DrawKillablePieces(olc::PixelGameEngine* pge, const std::vector<Piece*>& pieces, const olc::vf2d& lastPosition, const Board& board, const Piece& piece)
+// The engine's latest completed iteration, under Black's clock.
+void DrawEngineInfo(olc::PixelGameEngine* pge, const SearchInfo& info)
 {
-	std::vector<Piece*> killables = piece.GetKillablePieces(pieces, piece, lastPosition, board);
+	if (info.depth == 0)
+		return;
+	std::string text = "depth " + std::to_string(info.depth) + " score " + ScoreToUci(info.score)
+		+ " nodes " + std::to_string(info.nodes);
+	if (!info.pv.empty())
+		text += " pv " + MoveToUci(info.pv[0]);
+	pge->DrawStringDecal({ 5.0f, 22.0f }, text, olc::YELLOW);
+}
 
-	for (auto& killable : killables)
+// How the game ended, or an empty string while it goes on.
+std::string GameResult(const Position& position)
+{
+	MoveList moves;
+	GenerateLegalMoves(position, moves);
+	if (moves.Empty())
 	{
-		olc::vi2d pos = squareToScreen(screenToSquare(killable->position, board), board);
-		pge->FillRectDecal(pos, board.squareSize, olc::Pixel{ 250, 100, 100, 80 });
+		if (!position.InCheck())
+			return "Draw by stalemate";
+		return position.SideToMove() == WHITE ? "Black wins" : "White wins";
 	}
+	if (position.RepetitionCount() >= 2)
+		return "Draw by repetition";
+	if (position.IsFiftyMoveDraw())
+		return "Draw by fifty-move rule";
+	return "";
 }
 
 class ChessGame : public olc::PixelGameEngine
@@ -986,46 +571,130 @@ public:
 
 	~ChessGame()
 	{
-		for (int i = 0; i < nTotalPieces; i++)
+		for (auto& piece : pieces)
 		{
-			delete pieces[i];
+			delete piece;
 		}
 	}
 
 private:
 	void InitPieces()
 	{
+		position.SetFromFen(StartFen);
+		SyncPieces();
+	}
+
+	// Rebuilds the drawable pieces from the position, which takes care of captures, castling and promotions.
+	void SyncPieces()
+	{
+		for (auto& piece : pieces)
+		{
+			delete piece;
+		}
 		pieces.clear();
-		for (int i = 0; i < 8; i++)
+
+		for (Square square = SQ_A1; square <= SQ_H8; ++square)
+		{
+			if (!position.Empty(square))
+			{
+				pieces.push_back(createPiece(position.PieceOn(square), squareToScreen(squareToGrid(square), board)));
+			}
+		}
+	}
+
+	SearchLimits ClockLimits() const
+	{
+		SearchLimits limits;
+		for (Color side : { WHITE, BLACK })
+		{
+			limits.time[side] = clock.Remaining(side);
+			limits.increment[side] = clock.Increment();
+		}
+		return limits;
+	}
+
+	// The engine searches on its own thread. Each frame this only starts a search when it is the
+	// engine's turn and none is under way, or a ponder search on the reply it expects while the
+	// human thinks, and collects whatever the worker has sent since the last frame, so the frame
+	// time does not depend on the search.
+	void UpdateEngine()
+	{
+		if (position.SideToMove() == EngineSide && searchId == 0)
+		{
+			// Zero if the command queue is full, in which case the next frame tries again.
+			searchId = engine.Go(position, ClockLimits());
+		}
+		else if (position.SideToMove() != EngineSide && ponderMove != NoMove)
+		{
+			StartPondering();
+		}
+
+		EngineEvent event;
+		while (engine.Poll(event))
+		{
+			if (event.id == ponderId)
+			{
+				engineInfo = event.info;
+			}
+			else if (event.id == searchId)
+			{
+				engineInfo = event.info;
+				if (event.type == EngineEventType::BEST_MOVE)
+				{
+					searchId = 0;
+					if (!event.info.pv.empty())
+						position.MakeMove(event.info.pv[0]);
+					ponderMove = event.info.pv.size() > 1 ? event.info.pv[1] : NoMove;
+				}
+			}
+		}
+	}
+
+	// Searches the position after the human's expected reply, its clock not running until they play it.
+	void StartPondering()
+	{
+		MoveList moves;
+		GenerateLegalMoves(position, moves);
+		if (std::find(moves.begin(), moves.end(), ponderMove) != moves.end())
 		{
-			pieces.push_back(new Pawn{ squareToScreen({i, 1}, board), Piece::Color::BLACK });
-			pieces.push_back(new Pawn{ squareToScreen({i, 6}, board), Piece::Color::WHITE });
+			Position expected = position;
+			expected.MakeMove(ponderMove);
+			SearchLimits limits = ClockLimits();
+			limits.ponder = true;
+			ponderId = engine.Go(expected, limits);
+			ponderKey = expected.Key();
+			if (ponderId == 0)
+				return;
 		}
+		ponderMove = NoMove;
+	}
 
-		pieces.push_back(new King{ squareToScreen({4, 0}, board), Piece::Color::BLACK });
-		pieces.push_back(new King{ squareToScreen({4, 7}, board), Piece::Color::WHITE });
-		
-		pieces.push_back(new Queen{ squareToScreen({3, 0}, board), Piece::Color::BLACK });
-		pieces.push_back(new Queen{ squareToScreen({3, 7}, board), Piece::Color::WHITE });
-		
-		pieces.push_back(new Rook{ squareToScreen({0, 0}, board), Piece::Color::BLACK });
-		pieces.push_back(new Rook{ squareToScreen({0, 7}, board), Piece::Color::WHITE });
-		
-		pieces.push_back(new Rook{ squareToScreen({7, 0}, board), Piece::Color::BLACK });
-		pieces.push_back(new Rook{ squareToScreen({7, 7}, board), Piece::Color::WHITE });
-		
-		pieces.push_back(new Bishop{ squareToScreen({2, 0}, board), Piece::Color::BLACK });
-		pieces.push_back(new Bishop{ squareToScreen({2, 7}, board), Piece::Color::WHITE });
-		
-		pieces.push_back(new Bishop{ squareToScreen({5, 0}, board), Piece::Color::BLACK });
-		pieces.push_back(new Bishop{ squareToScreen({5, 7}, board), Piece::Color::WHITE });
-		
-		pieces.push_back(new Knight{ squareToScreen({6, 0}, board), Piece::Color::BLACK });
-		pieces.push_back(new Knight{ squareToScreen({6, 7}, board), Piece::Color::WHITE });
-		
-		pieces.push_back(new Knight{ squareToScreen({1, 0}, board), Piece::Color::BLACK });
-		pieces.push_back(new Knight{ squareToScreen({1, 7}, board), Piece::Color::WHITE });
+	// The human has moved: a ponder search on that very move goes on as the engine's search, with
+	// all it has found and left in the transposition table, and any other one is dropped.
+	void ResolvePonder()
+	{
+		if (ponderId == 0)
+			return;
+		if (position.Key() == ponderKey)
+		{
+			engine.PonderHit(ponderId);
+			searchId = ponderId;
+		}
+		else
+		{
+			engine.Stop();
+		}
+		ponderId = 0;
+	}
 
+	void EndGame(const std::string& gameResult)
+	{
+		clock.Stop();
+		engine.Stop();
+		searchId = ponderId = 0;
+		ponderMove = NoMove;
+		result = gameResult;
+		state = State::SHOWINGWINNER;
 	}
 
 public:
@@ -1035,6 +704,8 @@ public:
 		bottomPannelSize = { ScreenWidth(), 100 };
 		board = Board({ ScreenWidth(), ScreenHeight() }, { 8, 8 });
 		InitPieces();
+		controller.UpdateTurn(position.SideToMove());
+		clock.Start(position.SideToMove());
 		return true;
 	}
 
@@ -1044,54 +715,115 @@ public:
 		{
 		case State::GAMEPLAY:
 		{
-			Piece* lastGrabbed = controller.GetLastGrabbedpiece();
-			bool returned = false;
-			controller.LetUserDragDropPieces(pieces, board);
-			if (lastGrabbed != nullptr)
+			int gamePly = position.GamePly();
+			UpdateEngine();
+			if (position.SideToMove() != EngineSide && position.GamePly() == gamePly)
 			{
-				returned = ValidateMovement(this, pieces, controller.GetLastPosition(), *lastGrabbed, board);
+				Piece* lastGrabbed = controller.GetLastGrabbedpiece();
+				controller.LetUserDragDropPieces(pieces, board);
+				if (lastGrabbed != nullptr)
+				{
+					ValidateMovement(this, position, controller.GetLastPosition(), *lastGrabbed, board);
+				}
+			}
+			if (position.GamePly() != gamePly)
+			{
+				clock.Press();
+				if (position.GamePly() + MaxPly >= Position::MaxGamePly)
+				{
+					position.TrimHistory();
+				}
+				if (position.SideToMove() == EngineSide)
+				{
+					ResolvePonder();
+				}
+				controller.UpdateTurn(position.SideToMove());
+				SyncPieces();
+				controller.ForgetPieces();
+				std::string gameResult = GameResult(position);
+				if (!gameResult.empty())
+				{
+					EndGame(gameResult);
+				}
+			}
+			if (state == State::GAMEPLAY && clock.Flagged(clock.SideRunning()))
+			{
+				EndGame(clock.SideRunning() == WHITE ? "Black wins on time" : "White wins on time");
 			}
-			controller.UpdateTurn(this, 10.0, returned, state);
 
 			//Drawing
 			DrawBoard(this, board);
 			Piece* currentGrabbed = controller.GetGrabbedPiece();
 			if (currentGrabbed != nullptr)
 			{
-				DrawOccupiableSquares(this, pieces, controller.GetLastPosition(), board, *currentGrabbed);
-				DrawKillablePieces(this, pieces, controller.GetLastPosition(), board, *currentGrabbed);
+				DrawMoveTargets(this, position, controller.GetLastPosition(), board);
 			}
 
-			for (int i = 0; i < nTotalPieces; i++)
+			for (auto& pieceRef : pieces)
 			{
-				Piece& piece = *pieces[i];
+				Piece& piece = *pieceRef;
 				RenderPiece(this, board, piece, piece.GetColor() == Piece::Color::BLACK ? olc::BLACK : olc::WHITE, piece == *controller.GetGrabbedPiece());
 			}
 
 			DrawStringDecal({ 200, 200 }, controller.CurrentTurn(), olc::RED);
+			DrawClocks(this, clock);
+			DrawEngineInfo(this, engineInfo);
 
 			/*FillRectDecal({ (float)ScreenWidth() - sidePannelSize.x, 0.0f }, (olc::vf2d)sidePannelSize, olc::Pixel{ 100, 100, 100 });
 			FillRectDecal({ 0.0f, (float)ScreenHeight() - bottomPannelSize.y }, (olc::vf2d)bottomPannelSize, olc::Pixel{ 100, 100, 100 });*/
 			break;
 		}
+		case State::SHOWINGWINNER:
+		{
+			DrawBoard(this, board);
+			for (auto& piece : pieces)
+			{
+				RenderPiece(this, board, *piece, piece->GetColor() == Piece::Color::BLACK ? olc::BLACK : olc::WHITE, false);
+			}
+			DrawStringDecal({ 200, 200 }, result, olc::RED);
+			DrawClocks(this, clock);
+			DrawEngineInfo(this, engineInfo);
+			break;
+		}
+		default:
+			break;
 		}
 
 		return true;
 	}
 
+private:
+	static constexpr Color EngineSide = BLACK;
+	// Five minutes a side with a three second increment.
+	static constexpr int64_t BaseTime = 5 * 60 * 1000;
+	static constexpr int64_t Increment = 3 * 1000;
+
 private:
 	olc::vi2d sidePannelSize;
 	olc::vi2d bottomPannelSize;
 	State state = State::GAMEPLAY;
-	static constexpr int nTotalPieces = 16 * 2;
+	std::string result;
 	std::vector<Piece*> pieces{ };
+	Position position;
 	int decalLayer;
 	Board board;
 	Controller controller{ this };
+	ChessClock clock{ BaseTime, Increment };
+	EngineWorker engine;
+	// The id of the engine's search under way, zero if none.
+	uint64_t searchId = 0;
+	// The human's reply the engine expects, until a ponder search on it has been started.
+	Move ponderMove = NoMove;
+	// The ponder search under way and the key of the position it searches, zero if none.
+	uint64_t ponderId = 0;
+	uint64_t ponderKey = 0;
+	SearchInfo engineInfo;
 };
 
 int main()
 {
+	InitBitboards();
+	InitZobrist();
 	ChessGame game;
 	if (game.Construct(600, 600, 1, 1))
 		game.Start();
@@ -0,0 +1,163 @@
+#include "Bitboard.h"
+#include "Cpu.h"
+#include "Random.h"
+
+Magic RookMagics[SQUARE_NB];
+Magic BishopMagics[SQUARE_NB];
+Bitboard BetweenTable[SQUARE_NB][SQUARE_NB];
+Bitboard LineTable[SQUARE_NB][SQUARE_NB];
+bool UsePext = false;
+
+namespace
+{
+	// Returns the target square of a single step, or SQ_NONE if the step leaves the board.
+	Square Step(Square square, int fileDelta, int rankDelta)
+	{
+		int file = FileOf(square) + fileDelta;
+		int rank = RankOf(square) + rankDelta;
+		if (file < FILE_A || file > FILE_H || rank < RANK_1 || rank > RANK_8)
+			return SQ_NONE;
+		return MakeSquare(File(file), Rank(rank));
+	}
+
+	Bitboard RookTable[0x19000];
+	Bitboard BishopTable[0x1480];
+
+	// With PEXT the occupancy subsets index the table directly and no magic search is needed.
+	void InitMagics(PieceType type, Bitboard table[], Magic magics[], SliderBackend backend)
+	{
+		static Bitboard occupancy[4096], reference[4096];
+		static int epoch[4096];
+		int currentEpoch = 0;
+		for (int& e : epoch)
+			e = 0;
+		int size = 0;
+		// One seed per rank, picked so that the search below settles quickly on every square.
+		static const uint64_t seeds[RANK_NB] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+		for (Square square = SQ_A1; square <= SQ_H8; ++square)
+		{
+			// Edge squares never block a ray, so they are left out of the relevant occupancy.
+			Bitboard edges = ((Rank1BB | Rank8BB) & ~RankBB(square)) | ((FileABB | FileHBB) & ~FileBB(square));
+
+			Magic& m = magics[square];
+			m.mask = RayAttacks(type, square, 0) & ~edges;
+			m.shift = 64 - PopCount(m.mask);
+			m.attacks = square == SQ_A1 ? table : magics[square - 1].attacks + size;
+
+			// Enumerate every subset of the mask with the Carry-Rippler trick.
+			Bitboard subset = 0;
+			size = 0;
+			do
+			{
+				occupancy[size] = subset;
+				reference[size] = RayAttacks(type, square, subset);
+				size++;
+				subset = (subset - m.mask) & m.mask;
+			} while (subset);
+
+			if (backend == SliderBackend::PEXT)
+			{
+				m.magic = 0;
+#if CHESS_PEXT
+				for (int i = 0; i < size; i++)
+					m.attacks[Pext(occupancy[i], m.mask)] = reference[i];
+#endif
+				continue;
+			}
+
+			Prng rng{ seeds[RankOf(square)] };
+			for (int i = 0; i < size;)
+			{
+				// Candidates with few set bits are far more likely to be usable magics.
+				do
+				{
+					m.magic = rng.Sparse();
+				} while (PopCount((m.magic * m.mask) >> 56) < 6);
+
+				currentEpoch++;
+				for (i = 0; i < size; i++)
+				{
+					unsigned index = m.Index(occupancy[i]);
+					if (epoch[index] < currentEpoch)
+					{
+						epoch[index] = currentEpoch;
+						m.attacks[index] = reference[i];
+					}
+					else if (m.attacks[index] != reference[i])
+					{
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+void InitBitboards()
+{
+	for (Square a = SQ_A1; a <= SQ_H8; ++a)
+	{
+		for (Square b = SQ_A1; b <= SQ_H8; ++b)
+		{
+			BetweenTable[a][b] = LineTable[a][b] = 0;
+			for (PieceType type : { BISHOP, ROOK })
+			{
+				if (RayAttacks(type, a, 0) & SquareBB(b))
+				{
+					LineTable[a][b] = (RayAttacks(type, a, 0) & RayAttacks(type, b, 0)) | SquareBB(a) | SquareBB(b);
+					BetweenTable[a][b] = RayAttacks(type, a, SquareBB(b)) & RayAttacks(type, b, SquareBB(a));
+				}
+			}
+		}
+	}
+
+#if CHESS_PEXT
+	if (PextInlined && SetSliderBackend(SliderBackend::PEXT))
+		return;
+#endif
+	SetSliderBackend(SliderBackend::MAGIC);
+}
+
+bool SetSliderBackend(SliderBackend backend)
+{
+	if (backend == SliderBackend::PEXT && !(CHESS_PEXT && GetCpuInfo().fastPext))
+		return false;
+
+	InitMagics(ROOK, RookTable, RookMagics, backend);
+	InitMagics(BISHOP, BishopTable, BishopMagics, backend);
+	UsePext = backend == SliderBackend::PEXT;
+	return true;
+}
+
+SliderBackend GetSliderBackend()
+{
+	return UsePext ? SliderBackend::PEXT : SliderBackend::MAGIC;
+}
+
+Bitboard RayAttacks(PieceType type, Square square, Bitboard occupied)
+{
+	static const int rookDirections[4][2] = { { 0, 1 }, { 0, -1 }, { 1, 0 }, { -1, 0 } };
+	static const int bishopDirections[4][2] = { { 1, 1 }, { -1, -1 }, { 1, -1 }, { -1, 1 } };
+
+	Bitboard attacks = 0;
+	auto addRays = [&](const int (*directions)[2])
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			Square current = square;
+			while ((current = Step(current, directions[i][0], directions[i][1])) != SQ_NONE)
+			{
+				attacks |= SquareBB(current);
+				if (occupied & SquareBB(current))
+					break;
+			}
+		}
+	};
+
+	if (type == ROOK || type == QUEEN)
+		addRays(rookDirections);
+	if (type == BISHOP || type == QUEEN)
+		addRays(bishopDirections);
+	return attacks;
+}
@@ -0,0 +1,288 @@
+#pragma once
+#include "Types.h"
+
+// Define CHESS_NO_PEXT to build without the BMI2 PEXT slider backend.
+#if !defined(CHESS_NO_PEXT) && (defined(_M_X64) || defined(__x86_64__))
+#define CHESS_PEXT 1
+#else
+#define CHESS_PEXT 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif CHESS_PEXT
+#include <immintrin.h>
+#endif
+
+constexpr Bitboard FileABB = 0x0101010101010101ULL;
+constexpr Bitboard FileHBB = FileABB << 7;
+constexpr Bitboard Rank1BB = 0xFFULL;
+constexpr Bitboard Rank8BB = Rank1BB << (8 * 7);
+
+constexpr Bitboard SquareBB(Square square)
+{
+	return Bitboard(1) << square;
+}
+
+constexpr Bitboard FileBB(File file)
+{
+	return FileABB << file;
+}
+
+constexpr Bitboard FileBB(Square square)
+{
+	return FileBB(FileOf(square));
+}
+
+constexpr Bitboard RankBB(Rank rank)
+{
+	return Rank1BB << (8 * rank);
+}
+
+constexpr Bitboard RankBB(Square square)
+{
+	return RankBB(RankOf(square));
+}
+
+template<Direction D>
+constexpr Bitboard Shift(Bitboard b)
+{
+	return D == NORTH ? b << 8
+		: D == SOUTH ? b >> 8
+		: D == EAST ? (b & ~FileHBB) << 1
+		: D == WEST ? (b & ~FileABB) >> 1
+		: D == NORTH_EAST ? (b & ~FileHBB) << 9
+		: D == NORTH_WEST ? (b & ~FileABB) << 7
+		: D == SOUTH_EAST ? (b & ~FileHBB) >> 7
+		: D == SOUTH_WEST ? (b & ~FileABB) >> 9
+		: 0;
+}
+
+inline int PopCount(Bitboard b)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	return (int)__popcnt64(b);
+#elif defined(__GNUC__)
+	return __builtin_popcountll(b);
+#else
+	int count = 0;
+	for (; b; b &= b - 1)
+		count++;
+	return count;
+#endif
+}
+
+// Index of the least significant set bit. b must not be empty.
+inline Square Lsb(Bitboard b)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64(&index, b);
+	return Square(index);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if ((uint32_t)b)
+	{
+		_BitScanForward(&index, (uint32_t)b);
+		return Square(index);
+	}
+	_BitScanForward(&index, (uint32_t)(b >> 32));
+	return Square(index + 32);
+#else
+	return Square(__builtin_ctzll(b));
+#endif
+}
+
+inline Square PopLsb(Bitboard& b)
+{
+	Square square = Lsb(b);
+	b &= b - 1;
+	return square;
+}
+
+constexpr bool MoreThanOne(Bitboard b)
+{
+	return (b & (b - 1)) != 0;
+}
+
+// Squares attacked by every pawn of the given color in b at once.
+template<Color C>
+constexpr Bitboard PawnAttacksBB(Bitboard b)
+{
+	return C == WHITE ? Shift<NORTH_WEST>(b) | Shift<NORTH_EAST>(b) : Shift<SOUTH_WEST>(b) | Shift<SOUTH_EAST>(b);
+}
+
+constexpr Bitboard KnightAttacksBB(Bitboard b)
+{
+	Bitboard north = Shift<NORTH>(b), south = Shift<SOUTH>(b), east = Shift<EAST>(b), west = Shift<WEST>(b);
+	return Shift<NORTH_EAST>(north) | Shift<NORTH_WEST>(north) | Shift<SOUTH_EAST>(south) | Shift<SOUTH_WEST>(south)
+		| Shift<NORTH_EAST>(east) | Shift<SOUTH_EAST>(east) | Shift<NORTH_WEST>(west) | Shift<SOUTH_WEST>(west);
+}
+
+constexpr Bitboard KingAttacksBB(Bitboard b)
+{
+	Bitboard row = b | Shift<EAST>(b) | Shift<WEST>(b);
+	return (row | Shift<NORTH>(row) | Shift<SOUTH>(row)) ^ b;
+}
+
+// Attacks of a leaper from every square, filled in by the compiler.
+struct LeaperTable
+{
+	Bitboard attacks[SQUARE_NB] = {};
+};
+
+constexpr LeaperTable MakeLeaperTable(Bitboard (*attacksBB)(Bitboard))
+{
+	LeaperTable table;
+	for (int square = 0; square < SQUARE_NB; square++)
+		table.attacks[square] = attacksBB(SquareBB(Square(square)));
+	return table;
+}
+
+inline constexpr LeaperTable PawnAttackTable[COLOR_NB] = { MakeLeaperTable(PawnAttacksBB<WHITE>), MakeLeaperTable(PawnAttacksBB<BLACK>) };
+inline constexpr LeaperTable KnightAttackTable = MakeLeaperTable(KnightAttacksBB);
+inline constexpr LeaperTable KingAttackTable = MakeLeaperTable(KingAttacksBB);
+
+#if CHESS_PEXT
+#if defined(_MSC_VER) || defined(__BMI2__)
+constexpr bool PextInlined = true;
+
+inline Bitboard Pext(Bitboard b, Bitboard mask)
+{
+	return _pext_u64(b, mask);
+}
+#else
+// Built without -mbmi2, so GCC and Clang cannot inline the instruction into generic code.
+// Only ever called after cpuid has confirmed BMI2 support.
+constexpr bool PextInlined = false;
+
+__attribute__((target("bmi2"))) inline Bitboard Pext(Bitboard b, Bitboard mask)
+{
+	return _pext_u64(b, mask);
+}
+#endif
+#endif
+
+enum class SliderBackend
+{
+	MAGIC,
+	PEXT
+};
+
+// Fancy magic bitboard entry for one square: the relevant occupancy bits are gathered by a
+// multiply and shift (or by a single PEXT) into an index into that square's slice of the shared attack table.
+struct Magic
+{
+	Bitboard mask;
+	Bitboard magic;
+	Bitboard* attacks;
+	unsigned shift;
+
+	unsigned Index(Bitboard occupied) const
+	{
+		return unsigned(((occupied & mask) * magic) >> shift);
+	}
+};
+
+extern bool UsePext;
+
+extern Magic RookMagics[SQUARE_NB];
+extern Magic BishopMagics[SQUARE_NB];
+extern Bitboard BetweenTable[SQUARE_NB][SQUARE_NB];
+extern Bitboard LineTable[SQUARE_NB][SQUARE_NB];
+
+// Fills the slider, between and line tables. Must be called once before any other rules code runs.
+// Picks the PEXT slider backend when the CPU has fast BMI2 and the build can inline PEXT,
+// magic multiplication otherwise.
+void InitBitboards();
+
+// Rebuilds the slider tables for the requested backend. Returns false, and keeps
+// the current backend, if PEXT is requested on a CPU or build without it.
+// Not thread safe: no other thread may be generating attacks while the tables are rebuilt.
+bool SetSliderBackend(SliderBackend backend);
+SliderBackend GetSliderBackend();
+
+// Walks each ray from the square until it leaves the board or hits an occupied square (inclusive).
+// Only used to build the magic tables and as a reference for them.
+Bitboard RayAttacks(PieceType type, Square square, Bitboard occupied);
+
+inline Bitboard PawnAttacks(Color color, Square square)
+{
+	return PawnAttackTable[color].attacks[square];
+}
+
+inline Bitboard KnightAttacks(Square square)
+{
+	return KnightAttackTable.attacks[square];
+}
+
+inline Bitboard KingAttacks(Square square)
+{
+	return KingAttackTable.attacks[square];
+}
+
+// Squares strictly between a and b if they share a rank, file or diagonal, empty otherwise.
+inline Bitboard BetweenBB(Square a, Square b)
+{
+	return BetweenTable[a][b];
+}
+
+// The whole rank, file or diagonal through a and b, empty if they are not aligned.
+inline Bitboard LineBB(Square a, Square b)
+{
+	return LineTable[a][b];
+}
+
+inline Bitboard SliderAttacks(const Magic& m, Bitboard occupied)
+{
+#if CHESS_PEXT
+	if (UsePext)
+		return m.attacks[Pext(occupied, m.mask)];
+#endif
+	return m.attacks[m.Index(occupied)];
+}
+
+inline Bitboard BishopAttacks(Square square, Bitboard occupied)
+{
+	return SliderAttacks(BishopMagics[square], occupied);
+}
+
+inline Bitboard RookAttacks(Square square, Bitboard occupied)
+{
+	return SliderAttacks(RookMagics[square], occupied);
+}
+
+inline Bitboard QueenAttacks(Square square, Bitboard occupied)
+{
+	return BishopAttacks(square, occupied) | RookAttacks(square, occupied);
+}
+
+// Attacks of a non-pawn piece, with the type known at compile time so the lookup is inlined.
+template<PieceType Type>
+inline Bitboard Attacks(Square square, Bitboard occupied)
+{
+	static_assert(Type != PAWN, "pawn attacks depend on the color");
+	if constexpr (Type == KNIGHT)
+		return KnightAttacks(square);
+	else if constexpr (Type == BISHOP)
+		return BishopAttacks(square, occupied);
+	else if constexpr (Type == ROOK)
+		return RookAttacks(square, occupied);
+	else if constexpr (Type == QUEEN)
+		return QueenAttacks(square, occupied);
+	else
+		return KingAttacks(square);
+}
+
+inline Bitboard PieceAttacks(PieceType type, Square square, Bitboard occupied)
+{
+	switch (type)
+	{
+	case KNIGHT: return Attacks<KNIGHT>(square, occupied);
+	case BISHOP: return Attacks<BISHOP>(square, occupied);
+	case ROOK: return Attacks<ROOK>(square, occupied);
+	case QUEEN: return Attacks<QUEEN>(square, occupied);
+	case KING: return Attacks<KING>(square, occupied);
+	default: return 0;
+	}
+}
@@ -0,0 +1,63 @@
+#include "ChessClock.h"
+#include <algorithm>
+#include <cstdio>
+
+ChessClock::ChessClock(int64_t baseTime, int64_t increment) :
+	baseTime{ baseTime }, increment{ increment }
+{
+	Reset();
+}
+
+void ChessClock::Reset()
+{
+	remaining[WHITE] = remaining[BLACK] = baseTime;
+	side = WHITE;
+	running = false;
+}
+
+void ChessClock::Start(Color toMove)
+{
+	side = toMove;
+	turnStart = Clock::now();
+	running = true;
+}
+
+void ChessClock::Press()
+{
+	if (!running || Flagged(side))
+		return;
+	remaining[side] = Remaining(side) + increment;
+	side = ~side;
+	turnStart = Clock::now();
+}
+
+void ChessClock::Stop()
+{
+	if (!running)
+		return;
+	remaining[side] = Remaining(side);
+	running = false;
+}
+
+int64_t ChessClock::Remaining(Color of) const
+{
+	if (!running || of != side)
+		return remaining[of];
+	return std::max<int64_t>(remaining[of] - Elapsed(), 0);
+}
+
+int64_t ChessClock::Elapsed() const
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - turnStart).count();
+}
+
+std::string FormatClockTime(int64_t milliseconds)
+{
+	int64_t seconds = milliseconds / 1000;
+	char text[32];
+	if (seconds < 10)
+		std::snprintf(text, sizeof(text), "%d.%d", int(seconds), int(milliseconds / 100 % 10));
+	else
+		std::snprintf(text, sizeof(text), "%d:%02d", int(seconds / 60), int(seconds % 60));
+	return text;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "Types.h"
+
+// A two-sided game clock with a base time and a Fischer increment, both in milliseconds. Only the
+// side to move's clock runs; pressing it adds the increment and starts the opponent's.
+class ChessClock
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+public:
+	ChessClock(int64_t baseTime, int64_t increment);
+
+public:
+	// Both sides back to the base time, nothing running.
+	void Reset();
+
+	// Starts the given side's clock.
+	void Start(Color side);
+
+	// The running side has moved. Does nothing once that side has flagged.
+	void Press();
+
+	// Freezes both clocks, at the end of the game.
+	void Stop();
+
+	// Never negative.
+	int64_t Remaining(Color side) const;
+
+	bool Flagged(Color side) const
+	{
+		return Remaining(side) == 0;
+	}
+
+	bool Running() const
+	{
+		return running;
+	}
+
+	Color SideRunning() const
+	{
+		return side;
+	}
+
+	int64_t Increment() const
+	{
+		return increment;
+	}
+
+private:
+	int64_t Elapsed() const;
+
+private:
+	int64_t baseTime;
+	int64_t increment;
+	// What each side had when its clock was last stopped.
+	int64_t remaining[COLOR_NB];
+	Clock::time_point turnStart;
+	Color side = WHITE;
+	bool running = false;
+};
+
+// "m:ss" with tenths of a second under ten seconds, as clocks show it.
+std::string FormatClockTime(int64_t milliseconds);
@@ -0,0 +1,79 @@
+#include "Cpu.h"
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CHESS_CPUID 1
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define CHESS_CPUID 1
+#else
+#define CHESS_CPUID 0
+#endif
+
+namespace
+{
+#if CHESS_CPUID
+	void Cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4])
+	{
+#if defined(_MSC_VER)
+		int out[4];
+		__cpuidex(out, (int)leaf, (int)subleaf);
+		for (int i = 0; i < 4; i++)
+			regs[i] = (unsigned)out[i];
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+#endif
+
+	CpuInfo QueryCpuInfo()
+	{
+		CpuInfo info;
+#if CHESS_CPUID
+		unsigned regs[4];
+		Cpuid(0, 0, regs);
+		unsigned maxLeaf = regs[0];
+		char vendor[13] = {};
+		std::memcpy(vendor + 0, &regs[1], 4);
+		std::memcpy(vendor + 4, &regs[3], 4);
+		std::memcpy(vendor + 8, &regs[2], 4);
+		info.vendor = vendor;
+
+		Cpuid(1, 0, regs);
+		int baseFamily = (regs[0] >> 8) & 0xF;
+		int baseModel = (regs[0] >> 4) & 0xF;
+		info.family = baseFamily == 0xF ? baseFamily + ((regs[0] >> 20) & 0xFF) : baseFamily;
+		info.model = baseFamily == 0x6 || baseFamily == 0xF ? baseModel + (((regs[0] >> 16) & 0xF) << 4) : baseModel;
+
+		if (maxLeaf >= 7)
+		{
+			Cpuid(7, 0, regs);
+			info.bmi2 = (regs[1] >> 8) & 1;
+		}
+
+		Cpuid(0x80000000, 0, regs);
+		if (regs[0] >= 0x80000004)
+		{
+			char brand[49] = {};
+			for (unsigned i = 0; i < 3; i++)
+			{
+				Cpuid(0x80000002 + i, 0, regs);
+				std::memcpy(brand + i * 16, regs, 16);
+			}
+			info.brand = brand;
+			size_t first = info.brand.find_first_not_of(' ');
+			info.brand = first == std::string::npos ? "" : info.brand.substr(first);
+		}
+
+		info.fastPext = info.bmi2 && !(info.vendor == "AuthenticAMD" && info.family < 0x19);
+#endif
+		return info;
+	}
+}
+
+const CpuInfo& GetCpuInfo()
+{
+	static const CpuInfo info = QueryCpuInfo();
+	return info;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+
+struct CpuInfo
+{
+	std::string vendor;
+	std::string brand;
+	int family = 0;
+	int model = 0;
+	bool bmi2 = false;
+	// BMI2 is present and PEXT is not microcoded (AMD before Zen 3 takes hundreds of cycles per PEXT).
+	bool fastPext = false;
+};
+
+// Queried with cpuid on first use; all fields stay default on non-x86 targets.
+const CpuInfo& GetCpuInfo();
@@ -0,0 +1,105 @@
+#include "EngineWorker.h"
+#include <chrono>
+
+namespace
+{
+	// How long the worker sleeps when it finds no command. Only the worker waits; the caller never does.
+	constexpr std::chrono::milliseconds IdleSleep{ 1 };
+}
+
+EngineWorker::EngineWorker() :
+	search{ new Search() }
+{
+	thread = std::thread([this]() { Loop(); });
+}
+
+EngineWorker::~EngineWorker()
+{
+	quitting = true;
+	Stop();
+	EngineCommand command;
+	command.type = EngineCommandType::QUIT;
+	commands.Push(std::move(command));
+	thread.join();
+}
+
+uint64_t EngineWorker::Go(const Position& position, const SearchLimits& limits)
+{
+	EngineCommand command;
+	command.type = EngineCommandType::GO;
+	command.id = lastId + 1;
+	command.position = position;
+	command.limits = limits;
+	if (!commands.Push(std::move(command)))
+		return 0;
+	return ++lastId;
+}
+
+// The search itself polls these ids, see RunSearch, so neither request can reach it too early.
+void EngineWorker::Stop()
+{
+	cancelledId.store(lastId, std::memory_order_release);
+}
+
+void EngineWorker::PonderHit(uint64_t id)
+{
+	ponderHitId.store(id, std::memory_order_release);
+}
+
+bool EngineWorker::NewGame()
+{
+	EngineCommand command;
+	command.type = EngineCommandType::NEW_GAME;
+	return commands.Push(std::move(command));
+}
+
+void EngineWorker::Loop()
+{
+	EngineCommand command;
+	while (!quitting.load(std::memory_order_relaxed))
+	{
+		if (!commands.Pop(command))
+		{
+			std::this_thread::sleep_for(IdleSleep);
+			continue;
+		}
+
+		switch (command.type)
+		{
+		case EngineCommandType::GO:
+			if (!Cancelled(command.id))
+				RunSearch(command);
+			break;
+		case EngineCommandType::NEW_GAME:
+			search->Clear();
+			break;
+		case EngineCommandType::QUIT:
+			return;
+		}
+	}
+}
+
+void EngineWorker::RunSearch(const EngineCommand& command)
+{
+	EngineEvent event;
+	event.id = command.id;
+	event.type = EngineEventType::INFO;
+	// A ponder hit before the search has even begun makes it a normal one.
+	SearchLimits limits = command.limits;
+	if (HitWhilePondering(command.id))
+		limits.ponder = false;
+	SearchControl control;
+	control.stopped = [this, id = command.id]() { return Cancelled(id); };
+	control.ponderHit = [this, id = command.id]() { return HitWhilePondering(id); };
+	event.info = search->Run(command.position, limits, [this, &event](const SearchInfo& info)
+	{
+		// An info nobody has collected yet is not worth holding up the search for.
+		event.info = info;
+		events.Push(event);
+	}, control);
+
+	// The best move must not be lost, and the caller polls every frame.
+	event.type = EngineEventType::BEST_MOVE;
+	while (!events.Push(event) && !quitting.load(std::memory_order_relaxed))
+		std::this_thread::yield();
+}
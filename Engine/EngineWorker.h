@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include "Search.h"
+#include "SpscQueue.h"
+
+enum class EngineCommandType
+{
+	GO,
+	NEW_GAME,
+	QUIT
+};
+
+struct EngineCommand
+{
+	EngineCommandType type = EngineCommandType::QUIT;
+	uint64_t id = 0;
+	Position position;
+	SearchLimits limits;
+};
+
+enum class EngineEventType
+{
+	// An iteration completed.
+	INFO,
+	// The search is over; the info's pv is empty only if there was no legal move.
+	BEST_MOVE
+};
+
+struct EngineEvent
+{
+	EngineEventType type = EngineEventType::INFO;
+	// The id Go returned for the search this is about.
+	uint64_t id = 0;
+	SearchInfo info;
+};
+
+// Runs the search on a thread of its own, for a caller such as a render loop that must never
+// block. Commands go to the worker and events come back over single-producer single-consumer
+// queues, so the calling thread only ever takes a look at an atomic index. All member functions
+// are to be called from one and the same thread.
+class EngineWorker
+{
+public:
+	EngineWorker();
+	~EngineWorker();
+
+	EngineWorker(const EngineWorker&) = delete;
+	EngineWorker& operator=(const EngineWorker&) = delete;
+
+public:
+	// Queues a search of a copy of the position. Returns the id its events will carry, or zero if
+	// the command queue is full.
+	uint64_t Go(const Position& position, const SearchLimits& limits);
+
+	// Ends every search queued so far: the running one as soon as possible, though it still reports
+	// its best move, and those not yet begun without any event.
+	void Stop();
+
+	// The move the ponder search with this id expected has been played, see Search::PonderHit.
+	void PonderHit(uint64_t id);
+
+	// Forgets what earlier searches learned, once the searches queued before it are done. False if
+	// the command queue is full.
+	bool NewGame();
+
+	// Takes the next event, if there is one.
+	bool Poll(EngineEvent& event)
+	{
+		return events.Pop(event);
+	}
+
+private:
+	void Loop();
+	void RunSearch(const EngineCommand& command);
+	bool Cancelled(uint64_t id) const
+	{
+		return id <= cancelledId.load(std::memory_order_acquire);
+	}
+
+	bool HitWhilePondering(uint64_t id) const
+	{
+		return id == ponderHitId.load(std::memory_order_acquire);
+	}
+
+private:
+	static constexpr size_t CommandCapacity = 8;
+	static constexpr size_t EventCapacity = 256;
+
+	// The killer, history and principal variation tables are too large for the stack.
+	std::unique_ptr<Search> search;
+	SpscQueue<EngineCommand, CommandCapacity> commands;
+	SpscQueue<EngineEvent, EventCapacity> events;
+	// Searches with an id up to this one are to stop.
+	std::atomic<uint64_t> cancelledId{ 0 };
+	std::atomic<uint64_t> ponderHitId{ 0 };
+	std::atomic<bool> quitting{ false };
+	uint64_t lastId = 0;
+	std::thread thread;
+};
@@ -0,0 +1,140 @@
+#include "Evaluate.h"
+
+namespace
+{
+	// Piece-square tables from white's point of view, written rank 8 first as on a diagram.
+	const int PawnTable[SQUARE_NB] =
+	{
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		 50,  50,  50,  50,  50,  50,  50,  50,
+		 10,  10,  20,  30,  30,  20,  10,  10,
+		  5,   5,  10,  25,  25,  10,   5,   5,
+		  0,   0,   0,  20,  20,   0,   0,   0,
+		  5,  -5, -10,   0,   0, -10,  -5,   5,
+		  5,  10,  10, -20, -20,  10,  10,   5,
+		  0,   0,   0,   0,   0,   0,   0,   0
+	};
+
+	const int KnightTable[SQUARE_NB] =
+	{
+		-50, -40, -30, -30, -30, -30, -40, -50,
+		-40, -20,   0,   0,   0,   0, -20, -40,
+		-30,   0,  10,  15,  15,  10,   0, -30,
+		-30,   5,  15,  20,  20,  15,   5, -30,
+		-30,   0,  15,  20,  20,  15,   0, -30,
+		-30,   5,  10,  15,  15,  10,   5, -30,
+		-40, -20,   0,   5,   5,   0, -20, -40,
+		-50, -40, -30, -30, -30, -30, -40, -50
+	};
+
+	const int BishopTable[SQUARE_NB] =
+	{
+		-20, -10, -10, -10, -10, -10, -10, -20,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-10,   0,   5,  10,  10,   5,   0, -10,
+		-10,   5,   5,  10,  10,   5,   5, -10,
+		-10,   0,  10,  10,  10,  10,   0, -10,
+		-10,  10,  10,  10,  10,  10,  10, -10,
+		-10,   5,   0,   0,   0,   0,   5, -10,
+		-20, -10, -10, -10, -10, -10, -10, -20
+	};
+
+	const int RookTable[SQUARE_NB] =
+	{
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		  5,  10,  10,  10,  10,  10,  10,   5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		  0,   0,   0,   5,   5,   0,   0,   0
+	};
+
+	const int QueenTable[SQUARE_NB] =
+	{
+		-20, -10, -10,  -5,  -5, -10, -10, -20,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-10,   0,   5,   5,   5,   5,   0, -10,
+		 -5,   0,   5,   5,   5,   5,   0,  -5,
+		  0,   0,   5,   5,   5,   5,   0,  -5,
+		-10,   5,   5,   5,   5,   5,   0, -10,
+		-10,   0,   5,   0,   0,   0,   0, -10,
+		-20, -10, -10,  -5,  -5, -10, -10, -20
+	};
+
+	const int KingMiddlegameTable[SQUARE_NB] =
+	{
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-20, -30, -30, -40, -40, -30, -30, -20,
+		-10, -20, -20, -20, -20, -20, -20, -10,
+		 20,  20,   0,   0,   0,   0,  20,  20,
+		 20,  30,  10,   0,   0,  10,  30,  20
+	};
+
+	const int KingEndgameTable[SQUARE_NB] =
+	{
+		-50, -40, -30, -20, -20, -30, -40, -50,
+		-30, -20, -10,   0,   0, -10, -20, -30,
+		-30, -10,  20,  30,  30,  20, -10, -30,
+		-30, -10,  30,  40,  40,  30, -10, -30,
+		-30, -10,  30,  40,  40,  30, -10, -30,
+		-30, -10,  20,  30,  30,  20, -10, -30,
+		-30, -30,   0,   0,   0,   0, -30, -30,
+		-50, -30, -30, -30, -30, -30, -30, -50
+	};
+
+	const int* const PieceTables[PIECE_TYPE_NB] = { PawnTable, KnightTable, BishopTable, RookTable, QueenTable, KingMiddlegameTable };
+
+	// Game phase weight of each piece type; all pieces on the board add up to MaxPhase.
+	const int PhaseWeight[PIECE_TYPE_NB] = { 0, 1, 1, 2, 4, 0 };
+	constexpr int MaxPhase = 24;
+
+	constexpr int MobilityWeight = 2;
+	constexpr int KingPressureWeight = 6;
+
+	// The tables are drawn from white's side, so a white square is flipped to find its entry.
+	int TableIndex(Color color, Square square)
+	{
+		return color == WHITE ? square ^ 56 : square;
+	}
+}
+
+int Evaluate(const Position& position)
+{
+	int middlegame = 0;
+	int endgame = 0;
+	int phase = 0;
+
+	for (Color color : { WHITE, BLACK })
+	{
+		int sign = color == WHITE ? 1 : -1;
+		for (PieceType type = PAWN; type <= KING; ++type)
+		{
+			Bitboard pieces = position.Pieces(color, type);
+			phase += PhaseWeight[type] * PopCount(pieces);
+			while (pieces)
+			{
+				int index = TableIndex(color, PopLsb(pieces));
+				int value = PieceValue[type] + PieceTables[type][index];
+				middlegame += sign * value;
+				endgame += sign * (type == KING ? KingEndgameTable[index] : value);
+			}
+		}
+
+		// Squares attacked near the enemy king matter far more while there is material to attack with.
+		Bitboard kingZone = KingAttacks(position.KingSquare(~color));
+		int mobility = PopCount(position.Attacked(color) & ~position.Pieces(color));
+		int pressure = PopCount(position.Attacked(color) & kingZone) + PopCount(position.AttackedTwice(color) & kingZone);
+		middlegame += sign * (mobility * MobilityWeight + pressure * KingPressureWeight);
+		endgame += sign * mobility * MobilityWeight;
+	}
+
+	if (phase > MaxPhase)
+		phase = MaxPhase;
+	int score = (middlegame * phase + endgame * (MaxPhase - phase)) / MaxPhase;
+	return position.SideToMove() == WHITE ? score : -score;
+}
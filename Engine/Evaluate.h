@@ -0,0 +1,7 @@
+#pragma once
+#include "Position.h"
+
+// Static evaluation in centipawns from the side to move's point of view: material and
+// piece-square tables blended between middlegame and endgame by the remaining material,
+// plus mobility and king pressure read off the position's attack maps.
+int Evaluate(const Position& position);
@@ -0,0 +1,299 @@
+#include "MoveGen.h"
+
+namespace
+{
+	// Everything the generator needs to know about checks and pins, computed once per position.
+	struct LegalityInfo
+	{
+		Square king;
+		Bitboard checkers;
+		// Destinations that resolve a single check (capture the checker or block it); all squares when not in check.
+		Bitboard checkMask;
+		Bitboard pinned;
+	};
+
+	LegalityInfo ComputeLegalityInfo(const Position& position)
+	{
+		Color us = position.SideToMove();
+		Color them = ~us;
+		LegalityInfo info;
+		info.king = position.KingSquare(us);
+		info.checkers = position.Checkers();
+		info.checkMask = ~Bitboard(0);
+		if (info.checkers)
+		{
+			info.checkMask = MoreThanOne(info.checkers) ? 0 : info.checkers | BetweenBB(info.king, Lsb(info.checkers));
+		}
+
+		// Enemy sliders that would attack the king on an empty board pin our piece if it is the only one in between.
+		info.pinned = 0;
+		Bitboard snipers = (RookAttacks(info.king, 0) & (position.Pieces(them, ROOK) | position.Pieces(them, QUEEN)))
+			| (BishopAttacks(info.king, 0) & (position.Pieces(them, BISHOP) | position.Pieces(them, QUEEN)));
+		while (snipers)
+		{
+			Bitboard blockers = BetweenBB(info.king, PopLsb(snipers)) & position.Pieces();
+			if (blockers && !MoreThanOne(blockers) && (blockers & position.Pieces(us)))
+				info.pinned |= blockers;
+		}
+		return info;
+	}
+
+	// Destinations a piece on the square may use without exposing its own king.
+	Bitboard LegalMask(const LegalityInfo& info, Square from)
+	{
+		return info.pinned & SquareBB(from) ? info.checkMask & LineBB(info.king, from) : info.checkMask;
+	}
+
+	template<bool Promotion>
+	void AddPawnMove(Square from, Square to, MoveList& moves)
+	{
+		if constexpr (Promotion)
+		{
+			for (PieceType promotion : { QUEEN, ROOK, BISHOP, KNIGHT })
+				moves.Add(Move(from, to, MoveType::PROMOTION, promotion));
+		}
+		else
+		{
+			moves.Add(Move(from, to));
+		}
+	}
+
+	// Adds the pawn moves that land on the targets, each made by the pawn one D step behind.
+	// The pawns were shifted as a set, so pins are checked per move.
+	template<Direction D, bool Promotion>
+	void AddPawnMoves(const LegalityInfo& info, Bitboard targets, MoveList& moves)
+	{
+		while (targets)
+		{
+			Square to = PopLsb(targets);
+			Square from = to - D;
+			if (!(info.pinned & SquareBB(from)) || (LineBB(info.king, from) & SquareBB(to)))
+				AddPawnMove<Promotion>(from, to, moves);
+		}
+	}
+
+	// En passant can uncover the king along the rank of the two pawns, which no pin mask
+	// catches, so it is verified against the occupancy after the capture.
+	template<Color Us>
+	bool EnPassantIsLegal(const Position& position, const LegalityInfo& info, Square from, Square to)
+	{
+		constexpr Color Them = ~Us;
+		Square captured = to - PawnPush(Us);
+		if (!(info.checkMask & (SquareBB(to) | SquareBB(captured))))
+			return false;
+
+		Bitboard occupied = (position.Pieces() ^ SquareBB(from) ^ SquareBB(captured)) | SquareBB(to);
+		return !(RookAttacks(info.king, occupied) & (position.Pieces(Them, ROOK) | position.Pieces(Them, QUEEN)))
+			&& !(BishopAttacks(info.king, occupied) & (position.Pieces(Them, BISHOP) | position.Pieces(Them, QUEEN)));
+	}
+
+	template<Color Us, GenType Type>
+	void GeneratePawnMoves(const Position& position, const LegalityInfo& info, MoveList& moves)
+	{
+		constexpr Color Them = ~Us;
+		constexpr Direction Up = PawnPush(Us);
+		constexpr Direction UpEast = Direction(Up + EAST);
+		constexpr Direction UpWest = Direction(Up + WEST);
+		constexpr Bitboard Rank3 = RankBB(RelativeRank(Us, RANK_3));
+		constexpr Bitboard Rank7 = RankBB(RelativeRank(Us, RANK_7));
+
+		Bitboard empty = ~position.Pieces();
+		Bitboard enemies = position.Pieces(Them) & info.checkMask;
+		Bitboard pawns = position.Pieces(Us, PAWN);
+		Bitboard promoting = pawns & Rank7;
+		Bitboard others = pawns & ~Rank7;
+
+		if constexpr (Type != GenType::CAPTURES)
+		{
+			Bitboard single = Shift<Up>(others) & empty;
+			Bitboard twice = Shift<Up>(single & Rank3) & empty;
+			AddPawnMoves<Up, false>(info, single & info.checkMask, moves);
+			AddPawnMoves<Direction(Up + Up), false>(info, twice & info.checkMask, moves);
+		}
+		if constexpr (Type == GenType::QUIETS)
+			return;
+
+		AddPawnMoves<UpEast, false>(info, Shift<UpEast>(others) & enemies, moves);
+		AddPawnMoves<UpWest, false>(info, Shift<UpWest>(others) & enemies, moves);
+
+		// Promotions, quiet or not, change the material and are generated with the captures.
+		if (promoting)
+		{
+			AddPawnMoves<Up, true>(info, Shift<Up>(promoting) & empty & info.checkMask, moves);
+			AddPawnMoves<UpEast, true>(info, Shift<UpEast>(promoting) & enemies, moves);
+			AddPawnMoves<UpWest, true>(info, Shift<UpWest>(promoting) & enemies, moves);
+		}
+
+		Square ep = position.EpSquare();
+		if (ep != SQ_NONE)
+		{
+			Bitboard capturers = others & PawnAttacks(Them, ep);
+			while (capturers)
+			{
+				Square from = PopLsb(capturers);
+				if ((!(info.pinned & SquareBB(from)) || (LineBB(info.king, from) & SquareBB(ep)))
+					&& EnPassantIsLegal<Us>(position, info, from, ep))
+				{
+					moves.Add(Move(from, ep, MoveType::EN_PASSANT));
+				}
+			}
+		}
+	}
+
+	template<Color Us, PieceType Type>
+	void GeneratePieceMoves(const Position& position, const LegalityInfo& info, Bitboard targets, MoveList& moves)
+	{
+		Bitboard pieces = position.Pieces(Us, Type);
+		// A pinned knight can never stay on the pin line.
+		if constexpr (Type == KNIGHT)
+			pieces &= ~info.pinned;
+
+		while (pieces)
+		{
+			Square from = PopLsb(pieces);
+			Bitboard attacks = Attacks<Type>(from, position.Pieces()) & targets & LegalMask(info, from);
+			while (attacks)
+			{
+				moves.Add(Move(from, PopLsb(attacks)));
+			}
+		}
+	}
+
+	template<Color Us>
+	void GenerateKingMoves(const Position& position, const LegalityInfo& info, Bitboard targets, MoveList& moves)
+	{
+		// The attack map sees through our king, so it also covers the squares behind it on a checking ray.
+		targets &= KingAttacks(info.king) & ~position.Attacked(~Us);
+		while (targets)
+		{
+			moves.Add(Move(info.king, PopLsb(targets)));
+		}
+	}
+
+	template<Color Us>
+	void GenerateCastling(const Position& position, const LegalityInfo& info, MoveList& moves)
+	{
+		constexpr Color Them = ~Us;
+		constexpr int KingSide = Us == WHITE ? WHITE_OO : BLACK_OO;
+		constexpr int QueenSide = Us == WHITE ? WHITE_OOO : BLACK_OOO;
+		constexpr Square King = RelativeSquare(Us, SQ_E1);
+
+		if (!(position.CastlingRights() & (KingSide | QueenSide)) || info.checkers)
+			return;
+
+		auto tryCastle = [&](int right, Square rook, Square to, Square passed, Bitboard path)
+		{
+			if ((position.CastlingRights() & right)
+				&& position.PieceOn(rook) == MakePiece(Us, ROOK)
+				&& !(position.Pieces() & path)
+				&& !(position.Attacked(Them) & (SquareBB(passed) | SquareBB(to))))
+			{
+				moves.Add(Move(King, to, MoveType::CASTLING));
+			}
+		};
+
+		constexpr Square F = RelativeSquare(Us, SQ_F1), G = RelativeSquare(Us, SQ_G1);
+		constexpr Square D = RelativeSquare(Us, SQ_D1), C = RelativeSquare(Us, SQ_C1), B = RelativeSquare(Us, SQ_B1);
+		tryCastle(KingSide, RelativeSquare(Us, SQ_H1), G, F, SquareBB(F) | SquareBB(G));
+		tryCastle(QueenSide, RelativeSquare(Us, SQ_A1), C, D, SquareBB(D) | SquareBB(C) | SquareBB(B));
+	}
+
+	// Everything is specialized on the side to move, so colors, directions and relative squares are constants.
+	template<Color Us, GenType Type>
+	void GenerateAll(const Position& position, MoveList& moves)
+	{
+		LegalityInfo info = ComputeLegalityInfo(position);
+		Bitboard targets = Type == GenType::CAPTURES ? position.Pieces(~Us)
+			: Type == GenType::QUIETS ? ~position.Pieces()
+			: ~position.Pieces(Us);
+
+		GenerateKingMoves<Us>(position, info, targets, moves);
+		// In double check only the king may move.
+		if (MoreThanOne(info.checkers))
+			return;
+
+		targets &= info.checkMask;
+		GeneratePawnMoves<Us, Type>(position, info, moves);
+		GeneratePieceMoves<Us, KNIGHT>(position, info, targets, moves);
+		GeneratePieceMoves<Us, BISHOP>(position, info, targets, moves);
+		GeneratePieceMoves<Us, ROOK>(position, info, targets, moves);
+		GeneratePieceMoves<Us, QUEEN>(position, info, targets, moves);
+		if constexpr (Type != GenType::CAPTURES)
+			GenerateCastling<Us>(position, info, moves);
+	}
+
+	// Whether a pawn on the square can make the move, ignoring checks and pins.
+	bool PawnCanMove(const Position& position, Square from, Square to)
+	{
+		Color us = position.SideToMove();
+		if (PawnAttacks(us, from) & position.Pieces(~us) & SquareBB(to))
+			return true;
+
+		Square single = from + PawnPush(us);
+		if (!position.Empty(single))
+			return false;
+		return to == single || (RelativeRank(us, RankOf(from)) == RANK_2 && to == single + PawnPush(us) && position.Empty(to));
+	}
+}
+
+template<GenType Type>
+void GenerateMoves(const Position& position, MoveList& moves)
+{
+	if (position.SideToMove() == WHITE)
+		GenerateAll<WHITE, Type>(position, moves);
+	else
+		GenerateAll<BLACK, Type>(position, moves);
+}
+
+template void GenerateMoves<GenType::CAPTURES>(const Position& position, MoveList& moves);
+template void GenerateMoves<GenType::QUIETS>(const Position& position, MoveList& moves);
+template void GenerateMoves<GenType::ALL>(const Position& position, MoveList& moves);
+
+bool IsLegal(const Position& position, Move move)
+{
+	Color us = position.SideToMove();
+	Square from = move.From();
+	Square to = move.To();
+	PieceCode piece = position.PieceOn(from);
+	if (piece == NO_PIECE || ColorOf(piece) != us || (position.Pieces(us) & SquareBB(to)))
+		return false;
+
+	// Rare enough that comparing against the full list costs nothing in practice.
+	if (move.Type() == MoveType::CASTLING || move.Type() == MoveType::EN_PASSANT)
+	{
+		MoveList moves;
+		GenerateLegalMoves(position, moves);
+		return moves.Contains(move);
+	}
+
+	LegalityInfo info = ComputeLegalityInfo(position);
+	PieceType type = TypeOf(piece);
+	if (type == KING)
+	{
+		return move.Type() == MoveType::NORMAL && (KingAttacks(from) & ~position.Attacked(~us) & SquareBB(to));
+	}
+
+	if (MoreThanOne(info.checkers) || !(LegalMask(info, from) & SquareBB(to)))
+		return false;
+
+	if (type == PAWN)
+	{
+		bool promotes = RelativeRank(us, RankOf(to)) == RANK_8;
+		return promotes == (move.Type() == MoveType::PROMOTION) && PawnCanMove(position, from, to);
+	}
+	return move.Type() == MoveType::NORMAL && (PieceAttacks(type, from, position.Pieces()) & SquareBB(to));
+}
+
+std::string MoveToUci(Move move)
+{
+	std::string uci;
+	uci += char('a' + FileOf(move.From()));
+	uci += char('1' + RankOf(move.From()));
+	uci += char('a' + FileOf(move.To()));
+	uci += char('1' + RankOf(move.To()));
+	if (move.Type() == MoveType::PROMOTION)
+	{
+		uci += "pnbrqk"[move.Promotion()];
+	}
+	return uci;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <string>
+#include "Position.h"
+
+// No legal chess position has more than 218 moves.
+constexpr int MaxMoves = 256;
+
+// Fixed-capacity list with inline storage, so generating moves never touches the heap.
+class MoveList
+{
+public:
+	void Add(Move move)
+	{
+		moves[size++] = move;
+	}
+
+	void Clear()
+	{
+		size = 0;
+	}
+
+	int Size() const
+	{
+		return size;
+	}
+
+	bool Empty() const
+	{
+		return size == 0;
+	}
+
+	bool Contains(Move move) const
+	{
+		for (int i = 0; i < size; i++)
+		{
+			if (moves[i] == move)
+				return true;
+		}
+		return false;
+	}
+
+	Move& operator[](int index)
+	{
+		return moves[index];
+	}
+
+	Move operator[](int index) const
+	{
+		return moves[index];
+	}
+
+	Move* begin()
+	{
+		return moves;
+	}
+
+	Move* end()
+	{
+		return moves + size;
+	}
+
+	const Move* begin() const
+	{
+		return moves;
+	}
+
+	const Move* end() const
+	{
+		return moves + size;
+	}
+
+private:
+	Move moves[MaxMoves];
+	int size = 0;
+};
+
+enum class GenType
+{
+	// Captures, en passant and all promotions.
+	CAPTURES,
+	// Every other move, castling included.
+	QUIETS,
+	ALL
+};
+
+// Appends the legal moves of the requested kind for the side to move. CAPTURES and QUIETS
+// together give exactly ALL. Checkers and pins are computed once up front, so no move is
+// ever played to test it.
+template<GenType Type>
+void GenerateMoves(const Position& position, MoveList& moves);
+
+inline void GenerateLegalMoves(const Position& position, MoveList& moves)
+{
+	GenerateMoves<GenType::ALL>(position, moves);
+}
+
+// Whether the move, e.g. from the hash table or a killer slot, is legal in the position.
+// Cheaper than generating and searching the move list for all but castling and en passant.
+bool IsLegal(const Position& position, Move move);
+
+// Long algebraic notation as used by UCI, e.g. e2e4 or e7e8q.
+std::string MoveToUci(Move move);
@@ -0,0 +1,214 @@
+#include "MovePicker.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <utility>
+
+void History::Update(Color color, Move move, int bonus)
+{
+	int& score = scores[color][move.From()][move.To()];
+	score += bonus - score * std::abs(bonus) / MaxScore;
+}
+
+void PieceToHistory::Update(PieceCode piece, Square to, int bonus)
+{
+	int score = scores[piece][to];
+	scores[piece][to] = int16_t(score + bonus - score * std::abs(bonus) / History::MaxScore);
+}
+
+void ContinuationHistory::Clear()
+{
+	for (auto& byPiece : tables)
+		for (PieceToHistory& table : byPiece)
+			table = PieceToHistory();
+}
+
+void History::Clear()
+{
+	for (auto& byFrom : scores)
+		for (auto& byTo : byFrom)
+			for (int& score : byTo)
+				score = 0;
+}
+
+MovePicker::MovePicker(const Position& position, Move hashMove, const Move killers[2], Move counterMove, const History& history,
+	const PieceToHistory* const continuations[2]) :
+	position{ position }, history{ history }, hashMove{ hashMove }, continuations{ continuations[0], continuations[1] },
+	refutations{ killers[0], killers[1], counterMove }, stage{ Stage::HASH_MOVE }, capturesOnly{ false }
+{
+}
+
+MovePicker::MovePicker(const Position& position, Move hashMove, const History& history) :
+	position{ position }, history{ history }, hashMove{ hashMove }, continuations{ nullptr, nullptr },
+	refutations{ NoMove, NoMove, NoMove }, stage{ Stage::HASH_MOVE }, capturesOnly{ !position.InCheck() }
+{
+	if (capturesOnly && hashMove != NoMove
+		&& ((!position.IsCapture(hashMove) && hashMove.Type() != MoveType::PROMOTION) || IsSkippedUnderPromotion(hashMove)))
+	{
+		this->hashMove = NoMove;
+	}
+}
+
+Move MovePicker::Next()
+{
+	switch (stage)
+	{
+	case Stage::HASH_MOVE:
+		stage = Stage::GENERATE_CAPTURES;
+		if (hashMove != NoMove && IsLegal(position, hashMove))
+			return hashMove;
+		[[fallthrough]];
+
+	case Stage::GENERATE_CAPTURES:
+	{
+		MoveList captures;
+		GenerateMoves<GenType::CAPTURES>(position, captures);
+		for (Move move : captures)
+		{
+			if (!capturesOnly || !IsSkippedUnderPromotion(move))
+				moves[end++].move = move;
+		}
+		ScoreCaptures();
+		stage = Stage::GOOD_CAPTURES;
+	}
+		[[fallthrough]];
+
+	case Stage::GOOD_CAPTURES:
+		while (current < end)
+		{
+			Move move = PickBest();
+			current++;
+			if (move == hashMove)
+				continue;
+			if (!IsGoodCapture(move))
+			{
+				moves[badCaptureEnd++].move = move;
+				continue;
+			}
+			return move;
+		}
+		if (capturesOnly)
+		{
+			stage = Stage::DONE;
+			break;
+		}
+		stage = Stage::REFUTATIONS;
+		[[fallthrough]];
+
+	case Stage::REFUTATIONS:
+		while (refutationIndex < 3)
+		{
+			Move move = refutations[refutationIndex];
+			bool duplicate = move == hashMove || std::find(refutations, refutations + refutationIndex, move) != refutations + refutationIndex;
+			refutationIndex++;
+			// Refutations come from other nodes, so they may be captures or not even legal here.
+			if (move != NoMove && !duplicate && move.Type() != MoveType::PROMOTION
+				&& !position.IsCapture(move) && IsLegal(position, move))
+			{
+				return move;
+			}
+		}
+		stage = Stage::GENERATE_QUIETS;
+		[[fallthrough]];
+
+	case Stage::GENERATE_QUIETS:
+	{
+		// The quiet moves go after the losing captures, which are still needed for the last stage.
+		MoveList quiets;
+		GenerateMoves<GenType::QUIETS>(position, quiets);
+		current = end = badCaptureEnd;
+		for (Move move : quiets)
+			moves[end++].move = move;
+		ScoreQuiets();
+		stage = Stage::QUIETS;
+	}
+		[[fallthrough]];
+
+	case Stage::QUIETS:
+		while (current < end)
+		{
+			Move move = PickBest();
+			current++;
+			if (move != hashMove && std::find(std::begin(refutations), std::end(refutations), move) == std::end(refutations))
+				return move;
+		}
+		current = 0;
+		stage = Stage::BAD_CAPTURES;
+		[[fallthrough]];
+
+	case Stage::BAD_CAPTURES:
+		// Already in MVV-LVA order from the good captures stage.
+		if (current < badCaptureEnd)
+			return moves[current++].move;
+		stage = Stage::DONE;
+		[[fallthrough]];
+
+	case Stage::DONE:
+		break;
+	}
+	return NoMove;
+}
+
+Move MovePicker::PickBest()
+{
+	int best = current;
+	for (int i = current + 1; i < end; i++)
+	{
+		if (moves[i].score > moves[best].score)
+			best = i;
+	}
+	std::swap(moves[current], moves[best]);
+	return moves[current].move;
+}
+
+// Most valuable victim first, least valuable attacker to break ties.
+void MovePicker::ScoreCaptures()
+{
+	for (int i = current; i < end; i++)
+	{
+		Move move = moves[i].move;
+		moves[i].score = CaptureGain(move) * 16 - PieceValue[TypeOf(position.PieceOn(move.From()))] / 100;
+	}
+}
+
+void MovePicker::ScoreQuiets()
+{
+	Color us = position.SideToMove();
+	for (int i = current; i < end; i++)
+	{
+		Move move = moves[i].move;
+		PieceCode piece = position.PieceOn(move.From());
+		int score = history.Get(us, move);
+		for (const PieceToHistory* continuation : continuations)
+		{
+			if (continuation != nullptr)
+				score += continuation->Get(piece, move.To());
+		}
+		moves[i].score = score;
+	}
+}
+
+// Material won by the move itself, ignoring recaptures. Promotions count the piece gained.
+int MovePicker::CaptureGain(Move move) const
+{
+	PieceType victim = move.Type() == MoveType::EN_PASSANT ? PAWN : TypeOf(position.PieceOn(move.To()));
+	int gain = PieceValue[victim];
+	if (move.Type() == MoveType::PROMOTION)
+		gain += PieceValue[move.Promotion()] - PieceValue[PAWN];
+	return gain;
+}
+
+bool MovePicker::IsGoodCapture(Move move) const
+{
+	return position.See(move, 0);
+}
+
+// A queen is worth more than any other piece it could be, so in quiescence search an under-promotion
+// only adds nodes; a knight promotion that gives check is the exception worth keeping.
+bool MovePicker::IsSkippedUnderPromotion(Move move) const
+{
+	if (move.Type() != MoveType::PROMOTION || move.Promotion() == QUEEN)
+		return false;
+	return move.Promotion() != KNIGHT
+		|| !(KnightAttacks(move.To()) & SquareBB(position.KingSquare(~position.SideToMove())));
+}
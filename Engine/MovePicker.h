@@ -0,0 +1,112 @@
+#pragma once
+#include "MoveGen.h"
+
+// Scores quiet moves by how often they caused a beta cutoff, per side to move and from/to squares.
+struct History
+{
+	static constexpr int MaxScore = 16384;
+
+	int Get(Color color, Move move) const
+	{
+		return scores[color][move.From()][move.To()];
+	}
+
+	// Scores saturate towards +-MaxScore: the closer a score is to the bound, the less a bonus moves it.
+	void Update(Color color, Move move, int bonus);
+	void Clear();
+
+	int scores[COLOR_NB][SQUARE_NB][SQUARE_NB] = {};
+};
+
+// Scores quiet moves by moved piece and destination, with the same saturating updates as History.
+struct PieceToHistory
+{
+	int Get(PieceCode piece, Square to) const
+	{
+		return scores[piece][to];
+	}
+
+	void Update(PieceCode piece, Square to, int bonus);
+
+	// Bounded by History::MaxScore, so half the size of an int table.
+	int16_t scores[PIECE_CODE_NB][SQUARE_NB] = {};
+};
+
+// A PieceToHistory for every earlier move, by its piece and destination: how good a quiet move
+// has been as a reply to that move (one ply back) or as a follow-up to it (two plies back).
+struct ContinuationHistory
+{
+	PieceToHistory& At(PieceCode piece, Square to)
+	{
+		return tables[piece][to];
+	}
+
+	void Clear();
+
+	PieceToHistory tables[PIECE_CODE_NB][SQUARE_NB];
+};
+
+// Hands out the legal moves of a position one at a time, best first, generating each stage
+// only when the previous one is used up: the hash move, captures that do not lose material
+// by SEE in MVV-LVA order, the killers and the countermove, quiet moves by history and
+// finally losing captures. A cutoff on an early move saves generating and sorting the quiet
+// moves at all.
+class MovePicker
+{
+public:
+	// Quiet moves are scored by the butterfly history plus the continuation histories of the moves
+	// one and two plies back; either of those may be null, e.g. near the root.
+	MovePicker(const Position& position, Move hashMove, const Move killers[2], Move counterMove, const History& history,
+		const PieceToHistory* const continuations[2]);
+	// For quiescence search: no quiet moves, no losing captures and no under-promotions but knight
+	// promotions with check, the hash move only if it is one of the rest. In check it returns every
+	// evasion, like the main constructor.
+	MovePicker(const Position& position, Move hashMove, const History& history);
+
+public:
+	// NoMove once every legal move has been returned. Each move is returned exactly once.
+	Move Next();
+
+private:
+	enum class Stage
+	{
+		HASH_MOVE,
+		GENERATE_CAPTURES,
+		GOOD_CAPTURES,
+		REFUTATIONS,
+		GENERATE_QUIETS,
+		QUIETS,
+		BAD_CAPTURES,
+		DONE
+	};
+
+	struct ScoredMove
+	{
+		Move move;
+		int score;
+	};
+
+	// Moves the best scored move of [current, end) to current and returns it.
+	Move PickBest();
+	void ScoreCaptures();
+	void ScoreQuiets();
+	int CaptureGain(Move move) const;
+	bool IsGoodCapture(Move move) const;
+	bool IsSkippedUnderPromotion(Move move) const;
+
+private:
+	const Position& position;
+	const History& history;
+	Move hashMove;
+	const PieceToHistory* continuations[2];
+	// The killers, then the countermove: quiet moves that refuted similar positions.
+	Move refutations[3];
+	Stage stage;
+	bool capturesOnly;
+	int refutationIndex = 0;
+	int current = 0;
+	int end = 0;
+	// Losing captures are set aside at the front of the array, in slots whose moves were already returned.
+	int badCaptureEnd = 0;
+	ScoredMove moves[MaxMoves];
+};
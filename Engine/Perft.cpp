@@ -0,0 +1,157 @@
+#include "Perft.h"
+#include <atomic>
+#include <thread>
+#include "MoveGen.h"
+
+PerftHashTable::PerftHashTable(size_t megabytes)
+{
+	size_t count = 1;
+	while (count * 2 * sizeof(Entry) <= megabytes * 1024 * 1024)
+		count *= 2;
+	entries.reset(new Entry[count]);
+	mask = count - 1;
+}
+
+bool PerftHashTable::Probe(uint64_t key, int depth, uint64_t& nodes) const
+{
+	const Entry& entry = entries[key & mask];
+	uint64_t data = entry.data.load(std::memory_order_relaxed);
+	uint64_t check = entry.keyXorData.load(std::memory_order_relaxed);
+	if ((check ^ data) != key || int(data & 0xFF) != depth)
+		return false;
+	nodes = data >> 8;
+	return true;
+}
+
+void PerftHashTable::Store(uint64_t key, int depth, uint64_t nodes)
+{
+	Entry& entry = entries[key & mask];
+	uint64_t data = nodes << 8 | uint64_t(depth);
+	entry.keyXorData.store(key ^ data, std::memory_order_relaxed);
+	entry.data.store(data, std::memory_order_relaxed);
+}
+
+namespace
+{
+	// Leaves are counted in bulk: at depth 1 the legal move count is the answer, no move is made.
+	uint64_t CountNodes(Position& position, int depth, PerftHashTable* table)
+	{
+		if (depth == 0)
+			return 1;
+		MoveList moves;
+		GenerateLegalMoves(position, moves);
+		if (depth == 1)
+			return moves.Size();
+
+		uint64_t key = 0;
+		uint64_t nodes = 0;
+		if (table != nullptr)
+		{
+			key = position.Key();
+			if (table->Probe(key, depth, nodes))
+				return nodes;
+		}
+
+		for (Move move : moves)
+		{
+			position.MakeMove(move);
+			nodes += CountNodes(position, depth - 1, table);
+			position.UnmakeMove(move);
+		}
+
+		if (table != nullptr)
+			table->Store(key, depth, nodes);
+		return nodes;
+	}
+
+	// A subtree to count, identified by the moves leading to it from the root.
+	struct PerftTask
+	{
+		static constexpr int MaxLength = 4;
+
+		size_t rootIndex;
+		int length;
+		Move path[MaxLength];
+	};
+
+	void PlayPath(Position& position, const PerftTask& task)
+	{
+		for (int i = 0; i < task.length; i++)
+			position.MakeMove(task.path[i]);
+	}
+
+	void TakeBackPath(Position& position, const PerftTask& task)
+	{
+		for (int i = task.length - 1; i >= 0; i--)
+			position.UnmakeMove(task.path[i]);
+	}
+}
+
+uint64_t Perft(const Position& position, int depth)
+{
+	Position copy = position;
+	return CountNodes(copy, depth, nullptr);
+}
+
+std::vector<DivideEntry> PerftDivide(const Position& position, int depth, const PerftOptions& options)
+{
+	std::vector<DivideEntry> entries;
+	std::vector<PerftTask> tasks;
+	MoveList rootMoves;
+	GenerateLegalMoves(position, rootMoves);
+	for (Move move : rootMoves)
+	{
+		PerftTask task{ entries.size(), 1, {} };
+		task.path[0] = move;
+		tasks.push_back(task);
+		entries.push_back({ move, 0 });
+	}
+
+	// Split one ply deeper until there are enough subtrees to keep every thread busy
+	// despite their very uneven sizes.
+	int threads = options.threads > 0 ? options.threads : 1;
+	Position scratch = position;
+	while (threads > 1 && tasks.size() < size_t(threads) * 16 && !tasks.empty()
+		&& depth - tasks.front().length > 2 && tasks.front().length < PerftTask::MaxLength)
+	{
+		std::vector<PerftTask> deeper;
+		for (const PerftTask& task : tasks)
+		{
+			PlayPath(scratch, task);
+			MoveList moves;
+			GenerateLegalMoves(scratch, moves);
+			for (Move move : moves)
+			{
+				PerftTask next = task;
+				next.path[next.length++] = move;
+				deeper.push_back(next);
+			}
+			TakeBackPath(scratch, task);
+		}
+		tasks.swap(deeper);
+	}
+
+	std::vector<std::atomic<uint64_t>> counts(entries.size());
+	std::atomic<size_t> nextTask{ 0 };
+	auto worker = [&]()
+	{
+		Position local = position;
+		for (size_t i = nextTask++; i < tasks.size(); i = nextTask++)
+		{
+			PlayPath(local, tasks[i]);
+			counts[tasks[i].rootIndex] += CountNodes(local, depth - tasks[i].length, options.table);
+			TakeBackPath(local, tasks[i]);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (int i = 1; i < threads; i++)
+		pool.emplace_back(worker);
+	worker();
+	for (std::thread& thread : pool)
+		thread.join();
+
+	for (size_t i = 0; i < entries.size(); i++)
+		entries[i].nodes = counts[i];
+	return entries;
+}
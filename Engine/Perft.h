@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Position.h"
+
+struct DivideEntry
+{
+	Move move;
+	uint64_t nodes;
+};
+
+// Lock-free (key, depth) -> nodes table shared by all threads. Each entry stores the key XORed
+// with its data, so a torn write from two racing threads fails verification instead of
+// returning another position's count.
+class PerftHashTable
+{
+public:
+	explicit PerftHashTable(size_t megabytes);
+
+public:
+	bool Probe(uint64_t key, int depth, uint64_t& nodes) const;
+	void Store(uint64_t key, int depth, uint64_t nodes);
+
+private:
+	struct Entry
+	{
+		std::atomic<uint64_t> keyXorData{ 0 };
+		std::atomic<uint64_t> data{ 0 };
+	};
+
+	std::unique_ptr<Entry[]> entries;
+	size_t mask = 0;
+};
+
+struct PerftOptions
+{
+	int threads = 1;
+	// Optional, may be reused across calls since entries are keyed by depth too.
+	PerftHashTable* table = nullptr;
+};
+
+// Number of leaf nodes of the legal move tree of the given depth. Single threaded, no hash table.
+uint64_t Perft(const Position& position, int depth);
+
+// Perft split by root move, in generation order. Subtrees are spread over options.threads threads.
+std::vector<DivideEntry> PerftDivide(const Position& position, int depth, const PerftOptions& options = {});
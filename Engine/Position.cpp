@@ -0,0 +1,552 @@
+#include "Position.h"
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include "TranspositionTable.h"
+#include "Zobrist.h"
+
+const std::string StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+namespace
+{
+	const std::string PieceChars = "PNBRQKpnbrqk";
+
+	// Castling rights that survive a move touching the square.
+	int CastlingMask(Square square)
+	{
+		switch (square)
+		{
+		case SQ_A1: return ALL_CASTLING & ~WHITE_OOO;
+		case SQ_E1: return ALL_CASTLING & ~(WHITE_OO | WHITE_OOO);
+		case SQ_H1: return ALL_CASTLING & ~WHITE_OO;
+		case SQ_A8: return ALL_CASTLING & ~BLACK_OOO;
+		case SQ_E8: return ALL_CASTLING & ~(BLACK_OO | BLACK_OOO);
+		case SQ_H8: return ALL_CASTLING & ~BLACK_OO;
+		default: return ALL_CASTLING;
+		}
+	}
+
+	void CastlingRookSquares(Move move, Square& rookFrom, Square& rookTo)
+	{
+		bool kingSide = move.To() > move.From();
+		rookFrom = MakeSquare(kingSide ? FILE_H : FILE_A, RankOf(move.From()));
+		rookTo = MakeSquare(kingSide ? FILE_F : FILE_D, RankOf(move.From()));
+	}
+}
+
+Position::Position()
+{
+	Clear();
+}
+
+void Position::Clear()
+{
+	for (int c = 0; c < COLOR_NB; c++)
+	{
+		byColor[c] = 0;
+		for (int pt = 0; pt < PIECE_TYPE_NB; pt++)
+			byColorType[c][pt] = 0;
+	}
+	occupied = 0;
+	for (int s = 0; s < SQUARE_NB; s++)
+		board[s] = NO_PIECE;
+
+	sideToMove = WHITE;
+	castlingRights = NO_CASTLING;
+	epSquare = SQ_NONE;
+	halfmoveClock = 0;
+	fullmoveNumber = 1;
+	gamePly = 0;
+	key = pawnKey = materialKey = 0;
+	attacked[WHITE] = attacked[BLACK] = 0;
+	attackedTwice[WHITE] = attackedTwice[BLACK] = 0;
+	checkers = 0;
+	for (uint16_t& count : repetitionFilter)
+		count = 0;
+}
+
+bool Position::SetFromFen(const std::string& fen)
+{
+	Clear();
+	std::istringstream stream(fen);
+	std::string placement, side, castling, ep;
+	stream >> placement >> side >> castling >> ep;
+
+	File file = FILE_A;
+	Rank rank = RANK_8;
+	for (char c : placement)
+	{
+		if (c == '/')
+		{
+			if (rank == RANK_1)
+				return false;
+			--rank;
+			file = FILE_A;
+		}
+		else if (c >= '1' && c <= '8')
+		{
+			file = File(file + (c - '0'));
+		}
+		else
+		{
+			size_t index = PieceChars.find(c);
+			if (index == std::string::npos || file > FILE_H)
+				return false;
+			PutPiece(PieceCode(index), MakeSquare(file, rank));
+			++file;
+		}
+	}
+
+	if (side != "w" && side != "b")
+		return false;
+	sideToMove = side == "w" ? WHITE : BLACK;
+
+	for (char c : castling)
+	{
+		switch (c)
+		{
+		case 'K': castlingRights |= WHITE_OO; break;
+		case 'Q': castlingRights |= WHITE_OOO; break;
+		case 'k': castlingRights |= BLACK_OO; break;
+		case 'q': castlingRights |= BLACK_OOO; break;
+		default: break;
+		}
+	}
+
+	// Like MakeMove, only keep an en passant square that can actually be taken, so keys match.
+	if (ep.size() == 2 && ep[0] >= 'a' && ep[0] <= 'h' && ep[1] >= '1' && ep[1] <= '8')
+	{
+		Square square = MakeSquare(File(ep[0] - 'a'), Rank(ep[1] - '1'));
+		if (PawnAttacks(~sideToMove, square) & Pieces(sideToMove, PAWN))
+			epSquare = square;
+	}
+
+	key ^= Zobrist::castling[castlingRights];
+	if (epSquare != SQ_NONE)
+		key ^= Zobrist::enPassant[FileOf(epSquare)];
+	if (sideToMove == BLACK)
+		key ^= Zobrist::sideToMove;
+
+	if (!(stream >> halfmoveClock))
+		halfmoveClock = 0;
+	if (!(stream >> fullmoveNumber))
+		fullmoveNumber = 1;
+
+	if (PopCount(Pieces(WHITE, KING)) != 1 || PopCount(Pieces(BLACK, KING)) != 1)
+		return false;
+	RebuildAttacks(WHITE);
+	RebuildAttacks(BLACK);
+	UpdateCheckers();
+	repetitionFilter[key & (RepetitionFilterSize - 1)]++;
+	return true;
+}
+
+std::string Position::GetFen() const
+{
+	std::string fen;
+	for (Rank rank = RANK_8; rank >= RANK_1; --rank)
+	{
+		int empty = 0;
+		for (File file = FILE_A; file <= FILE_H; ++file)
+		{
+			PieceCode piece = board[MakeSquare(file, rank)];
+			if (piece == NO_PIECE)
+			{
+				empty++;
+				continue;
+			}
+			if (empty)
+			{
+				fen += char('0' + empty);
+				empty = 0;
+			}
+			fen += PieceChars[piece];
+		}
+		if (empty)
+			fen += char('0' + empty);
+		if (rank != RANK_1)
+			fen += '/';
+	}
+
+	fen += sideToMove == WHITE ? " w " : " b ";
+	if (castlingRights & WHITE_OO) fen += 'K';
+	if (castlingRights & WHITE_OOO) fen += 'Q';
+	if (castlingRights & BLACK_OO) fen += 'k';
+	if (castlingRights & BLACK_OOO) fen += 'q';
+	if (castlingRights == NO_CASTLING) fen += '-';
+
+	if (epSquare == SQ_NONE)
+	{
+		fen += " -";
+	}
+	else
+	{
+		fen += ' ';
+		fen += char('a' + FileOf(epSquare));
+		fen += char('1' + RankOf(epSquare));
+	}
+
+	fen += ' ' + std::to_string(halfmoveClock) + ' ' + std::to_string(fullmoveNumber);
+	return fen;
+}
+
+void Position::PutPiece(PieceCode piece, Square square)
+{
+	Bitboard bb = SquareBB(square);
+	// The material key hashes (piece, count before the change), so adding and removing the n-th piece cancel out.
+	materialKey ^= Zobrist::pieceSquare[piece][PopCount(byColorType[ColorOf(piece)][TypeOf(piece)])];
+	key ^= Zobrist::pieceSquare[piece][square];
+	if (TypeOf(piece) == PAWN)
+		pawnKey ^= Zobrist::pieceSquare[piece][square];
+	board[square] = piece;
+	byColorType[ColorOf(piece)][TypeOf(piece)] |= bb;
+	byColor[ColorOf(piece)] |= bb;
+	occupied |= bb;
+}
+
+void Position::RemovePiece(Square square)
+{
+	PieceCode piece = board[square];
+	Bitboard bb = SquareBB(square);
+	byColorType[ColorOf(piece)][TypeOf(piece)] ^= bb;
+	byColor[ColorOf(piece)] ^= bb;
+	occupied ^= bb;
+	board[square] = NO_PIECE;
+	materialKey ^= Zobrist::pieceSquare[piece][PopCount(byColorType[ColorOf(piece)][TypeOf(piece)])];
+	key ^= Zobrist::pieceSquare[piece][square];
+	if (TypeOf(piece) == PAWN)
+		pawnKey ^= Zobrist::pieceSquare[piece][square];
+}
+
+void Position::MovePiece(Square from, Square to)
+{
+	PieceCode piece = board[from];
+	Bitboard fromTo = SquareBB(from) | SquareBB(to);
+	byColorType[ColorOf(piece)][TypeOf(piece)] ^= fromTo;
+	byColor[ColorOf(piece)] ^= fromTo;
+	occupied ^= fromTo;
+	board[from] = NO_PIECE;
+	board[to] = piece;
+	uint64_t fromToKey = Zobrist::pieceSquare[piece][from] ^ Zobrist::pieceSquare[piece][to];
+	key ^= fromToKey;
+	if (TypeOf(piece) == PAWN)
+		pawnKey ^= fromToKey;
+}
+
+void Position::MakeMove(Move move)
+{
+	assert(gamePly < MaxGamePly);
+	Color us = sideToMove;
+	Color them = ~us;
+	PieceType moved = TypeOf(board[move.From()]);
+	Square captureSquare = move.Type() == MoveType::EN_PASSANT ? move.To() - PawnPush(us) : move.To();
+
+	UndoInfo& undo = history[gamePly++];
+	undo.captured = move.Type() == MoveType::CASTLING ? NO_PIECE : board[captureSquare];
+	undo.castlingRights = castlingRights;
+	undo.epSquare = epSquare;
+	undo.halfmoveClock = halfmoveClock;
+	undo.key = key;
+	undo.pawnKey = pawnKey;
+	undo.materialKey = materialKey;
+	for (Color color : { WHITE, BLACK })
+	{
+		undo.attacked[color] = attacked[color];
+		undo.attackedTwice[color] = attackedTwice[color];
+	}
+	undo.checkers = checkers;
+
+	halfmoveClock++;
+	if (undo.captured != NO_PIECE)
+	{
+		RemovePiece(captureSquare);
+		halfmoveClock = 0;
+	}
+
+	Bitboard changed = SquareBB(move.From()) | SquareBB(move.To()) | SquareBB(captureSquare);
+	if (move.Type() == MoveType::CASTLING)
+	{
+		Square rookFrom, rookTo;
+		CastlingRookSquares(move, rookFrom, rookTo);
+		MovePiece(rookFrom, rookTo);
+		changed |= SquareBB(rookFrom) | SquareBB(rookTo);
+	}
+	MovePiece(move.From(), move.To());
+
+	if (move.Type() == MoveType::PROMOTION)
+	{
+		RemovePiece(move.To());
+		PutPiece(MakePiece(us, move.Promotion()), move.To());
+	}
+
+	if (epSquare != SQ_NONE)
+		key ^= Zobrist::enPassant[FileOf(epSquare)];
+	epSquare = SQ_NONE;
+	if (moved == PAWN)
+	{
+		halfmoveClock = 0;
+		// Only record the en passant square when an enemy pawn can actually take.
+		Square skipped = move.From() + PawnPush(us);
+		if ((move.To() ^ move.From()) == 16 && (PawnAttacks(us, skipped) & Pieces(them, PAWN)))
+		{
+			epSquare = skipped;
+			key ^= Zobrist::enPassant[FileOf(epSquare)];
+		}
+	}
+
+	key ^= Zobrist::castling[castlingRights];
+	castlingRights &= CastlingMask(move.From()) & CastlingMask(move.To());
+	key ^= Zobrist::castling[castlingRights];
+
+	if (us == BLACK)
+		fullmoveNumber++;
+	sideToMove = them;
+	key ^= Zobrist::sideToMove;
+	if (prefetchTable != nullptr)
+		prefetchTable->Prefetch(key);
+	UpdateAttacks(us, changed, undo.captured != NO_PIECE);
+	repetitionFilter[key & (RepetitionFilterSize - 1)]++;
+}
+
+void Position::UnmakeMove(Move move)
+{
+	assert(gamePly > 0);
+	const UndoInfo& undo = history[--gamePly];
+	repetitionFilter[key & (RepetitionFilterSize - 1)]--;
+	Color us = ~sideToMove;
+	sideToMove = us;
+	if (us == BLACK)
+		fullmoveNumber--;
+
+	if (move.Type() == MoveType::PROMOTION)
+	{
+		RemovePiece(move.To());
+		PutPiece(MakePiece(us, PAWN), move.To());
+	}
+	MovePiece(move.To(), move.From());
+
+	if (move.Type() == MoveType::CASTLING)
+	{
+		Square rookFrom, rookTo;
+		CastlingRookSquares(move, rookFrom, rookTo);
+		MovePiece(rookTo, rookFrom);
+	}
+
+	if (undo.captured != NO_PIECE)
+	{
+		PutPiece(undo.captured, move.Type() == MoveType::EN_PASSANT ? move.To() - PawnPush(us) : move.To());
+	}
+
+	castlingRights = undo.castlingRights;
+	epSquare = undo.epSquare;
+	halfmoveClock = undo.halfmoveClock;
+	// The piece moves above already undid the piece-square keys; the saved copies also restore side, castling and en passant.
+	key = undo.key;
+	pawnKey = undo.pawnKey;
+	materialKey = undo.materialKey;
+	for (Color color : { WHITE, BLACK })
+	{
+		attacked[color] = undo.attacked[color];
+		attackedTwice[color] = undo.attackedTwice[color];
+	}
+	checkers = undo.checkers;
+}
+
+// The side that moved always gets its map rebuilt. The other side's pieces stand where they were,
+// so unless one was captured its map changes only if one of its sliders has a ray through a
+// square the move changed: the first such square on a ray is reached both before and after the
+// move. Two lookups per changed square, with the kings taken out to cover the x-ray through the
+// enemy king, find those sliders; about half of all moves leave the other side's map as it was.
+void Position::UpdateAttacks(Color moved, Bitboard changed, bool captured)
+{
+	RebuildAttacks(moved);
+	Color other = ~moved;
+	bool affected = captured;
+	Bitboard occupancy = occupied ^ Pieces(KING);
+	Bitboard diagonal = Pieces(other, BISHOP) | Pieces(other, QUEEN);
+	Bitboard straight = Pieces(other, ROOK) | Pieces(other, QUEEN);
+	while (changed && !affected)
+	{
+		Square square = PopLsb(changed);
+		affected = (BishopAttacks(square, occupancy) & diagonal) || (RookAttacks(square, occupancy) & straight);
+	}
+	if (affected)
+		RebuildAttacks(other);
+	UpdateCheckers();
+}
+
+void Position::RebuildAttacks(Color color)
+{
+	Bitboard occupancy = occupied ^ Pieces(~color, KING);
+	Bitboard pawns = Pieces(color, PAWN);
+	Bitboard west = color == WHITE ? Shift<NORTH_WEST>(pawns) : Shift<SOUTH_WEST>(pawns);
+	Bitboard east = color == WHITE ? Shift<NORTH_EAST>(pawns) : Shift<SOUTH_EAST>(pawns);
+	Bitboard once = west | east;
+	Bitboard twice = west & east;
+	for (PieceType type = KNIGHT; type <= KING; ++type)
+	{
+		Bitboard pieces = Pieces(color, type);
+		while (pieces)
+		{
+			Bitboard attacks = PieceAttacks(type, PopLsb(pieces), occupancy);
+			twice |= once & attacks;
+			once |= attacks;
+		}
+	}
+	attacked[color] = once;
+	attackedTwice[color] = twice;
+}
+
+// Only pieces attacking the king's square can give check, and mostly there are none.
+void Position::UpdateCheckers()
+{
+	Square king = KingSquare(sideToMove);
+	checkers = (attacked[~sideToMove] & SquareBB(king)) ? AttackersTo(king, occupied) & Pieces(~sideToMove) : 0;
+}
+
+int Position::RepetitionCount() const
+{
+	if (repetitionFilter[key & (RepetitionFilterSize - 1)] < 2)
+		return 0;
+
+	// history[ply].key is the key of the position at that ply; only every other one has the same side to move.
+	int count = 0;
+	int oldest = gamePly - std::min(halfmoveClock, gamePly);
+	for (int ply = gamePly - 4; ply >= oldest; ply -= 2)
+	{
+		if (history[ply].key == key)
+			count++;
+	}
+	return count;
+}
+
+void Position::TrimHistory()
+{
+	int keep = std::min({ halfmoveClock, gamePly, 100 });
+	int drop = gamePly - keep;
+	for (int ply = 0; ply < drop; ply++)
+		repetitionFilter[history[ply].key & (RepetitionFilterSize - 1)]--;
+	std::copy(history + drop, history + gamePly, history);
+	gamePly = keep;
+}
+
+void Position::MakeNullMove()
+{
+	assert(gamePly < MaxGamePly && !InCheck());
+	UndoInfo& undo = history[gamePly++];
+	undo.captured = NO_PIECE;
+	undo.castlingRights = castlingRights;
+	undo.epSquare = epSquare;
+	undo.halfmoveClock = halfmoveClock;
+	undo.key = key;
+	undo.pawnKey = pawnKey;
+	undo.materialKey = materialKey;
+	for (Color color : { WHITE, BLACK })
+	{
+		undo.attacked[color] = attacked[color];
+		undo.attackedTwice[color] = attackedTwice[color];
+	}
+	undo.checkers = checkers;
+
+	if (epSquare != SQ_NONE)
+		key ^= Zobrist::enPassant[FileOf(epSquare)];
+	epSquare = SQ_NONE;
+	halfmoveClock = 0;
+	sideToMove = ~sideToMove;
+	key ^= Zobrist::sideToMove;
+	if (prefetchTable != nullptr)
+		prefetchTable->Prefetch(key);
+	// No piece moved, so the attack maps stand; the side now to move cannot be in check, or the
+	// previous one could have taken its king.
+	checkers = 0;
+	repetitionFilter[key & (RepetitionFilterSize - 1)]++;
+}
+
+void Position::UnmakeNullMove()
+{
+	assert(gamePly > 0);
+	const UndoInfo& undo = history[--gamePly];
+	repetitionFilter[key & (RepetitionFilterSize - 1)]--;
+	sideToMove = ~sideToMove;
+	epSquare = undo.epSquare;
+	halfmoveClock = undo.halfmoveClock;
+	key = undo.key;
+	checkers = undo.checkers;
+}
+
+uint64_t Position::ComputeKey() const
+{
+	uint64_t key = 0;
+	Bitboard pieces = occupied;
+	while (pieces)
+	{
+		Square square = PopLsb(pieces);
+		key ^= Zobrist::pieceSquare[board[square]][square];
+	}
+
+	key ^= Zobrist::castling[castlingRights];
+	if (epSquare != SQ_NONE)
+		key ^= Zobrist::enPassant[FileOf(epSquare)];
+	if (sideToMove == BLACK)
+		key ^= Zobrist::sideToMove;
+	return key;
+}
+
+Bitboard Position::AttackersTo(Square square, Bitboard occupancy) const
+{
+	return (PawnAttacks(BLACK, square) & Pieces(WHITE, PAWN))
+		| (PawnAttacks(WHITE, square) & Pieces(BLACK, PAWN))
+		| (KnightAttacks(square) & Pieces(KNIGHT))
+		| (KingAttacks(square) & Pieces(KING))
+		| (BishopAttacks(square, occupancy) & (Pieces(BISHOP) | Pieces(QUEEN)))
+		| (RookAttacks(square, occupancy) & (Pieces(ROOK) | Pieces(QUEEN)));
+}
+
+bool Position::See(Move move, int threshold) const
+{
+	if (move.Type() != MoveType::NORMAL)
+		return threshold <= 0;
+
+	Square from = move.From();
+	Square to = move.To();
+	// swap is what the side to recapture must win back for the exchange to stay at or above the threshold.
+	int swap = PieceValue[TypeOf(board[to])] - threshold;
+	if (swap < 0)
+		return false;
+	swap = PieceValue[TypeOf(board[from])] - swap;
+	if (swap <= 0)
+		return true;
+
+	Color side = ColorOf(board[from]);
+	Bitboard occupancy = occupied ^ SquareBB(from) ^ SquareBB(to);
+	Bitboard attackers = AttackersTo(to, occupancy);
+	Bitboard diagonal = Pieces(BISHOP) | Pieces(QUEEN);
+	Bitboard straight = Pieces(ROOK) | Pieces(QUEEN);
+	bool result = true;
+	while (true)
+	{
+		side = ~side;
+		attackers &= occupancy;
+		Bitboard sideAttackers = attackers & Pieces(side);
+		if (!sideAttackers)
+			break;
+		result = !result;
+
+		PieceType type = PAWN;
+		while (!(sideAttackers & Pieces(side, type)))
+			++type;
+		// The king can only recapture if nothing defends the square any more.
+		if (type == KING)
+			return (attackers & ~Pieces(side)) ? !result : result;
+
+		swap = PieceValue[type] - swap;
+		if (swap < int(result))
+			break;
+		occupancy ^= SquareBB(Lsb(sideAttackers & Pieces(side, type)));
+		if (type == PAWN || type == BISHOP || type == QUEEN)
+			attackers |= BishopAttacks(to, occupancy) & diagonal;
+		if (type == ROOK || type == QUEEN)
+			attackers |= RookAttacks(to, occupancy) & straight;
+	}
+	return result;
+}
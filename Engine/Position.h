@@ -0,0 +1,251 @@
+#pragma once
+#include <string>
+#include "Bitboard.h"
+#include "Zobrist.h"
+
+extern const std::string StartFen;
+
+class TranspositionTable;
+
+// What MakeMove cannot recompute when the move is taken back.
+struct UndoInfo
+{
+	PieceCode captured;
+	int castlingRights;
+	Square epSquare;
+	int halfmoveClock;
+	uint64_t key;
+	uint64_t pawnKey;
+	uint64_t materialKey;
+	Bitboard attacked[COLOR_NB];
+	Bitboard attackedTwice[COLOR_NB];
+	Bitboard checkers;
+};
+
+// Board state built on bitboards: one bitboard per piece type and color, occupancy
+// bitboards and a 64-entry mailbox that are all kept in sync by PutPiece/RemovePiece/MovePiece.
+class Position
+{
+public:
+	// Capacity of the undo stack, i.e. the longest line that can be played from the FEN position
+	// without TrimHistory.
+	static constexpr int MaxGamePly = 1024;
+	// Slots of the repetition filter, a power of two.
+	static constexpr int RepetitionFilterSize = 4096;
+
+public:
+	Position();
+
+public:
+	void Clear();
+	bool SetFromFen(const std::string& fen);
+	std::string GetFen() const;
+
+	void PutPiece(PieceCode piece, Square square);
+	void RemovePiece(Square square);
+	void MovePiece(Square from, Square to);
+
+	// Plays a legal move for the side to move and pushes what is needed to take it back.
+	// Neither call allocates; the undo stack is a fixed array inside the position.
+	void MakeMove(Move move);
+	// Takes back the last move played, which must be the one passed in.
+	void UnmakeMove(Move move);
+
+	// Passes the turn, for null move pruning; not while in check. The halfmove clock restarts, so
+	// that no position before the null move counts as a repetition of one after it.
+	void MakeNullMove();
+	void UnmakeNullMove();
+
+	// Makes MakeMove prefetch the table's bucket for the new position as soon as its key is
+	// known, so the cache miss overlaps the attack map rebuild. Null turns prefetching off.
+	void SetPrefetchTable(const TranspositionTable* table)
+	{
+		prefetchTable = table;
+	}
+
+	int GamePly() const
+	{
+		return gamePly;
+	}
+
+	PieceCode PieceOn(Square square) const
+	{
+		return board[square];
+	}
+
+	bool Empty(Square square) const
+	{
+		return board[square] == NO_PIECE;
+	}
+
+	Bitboard Pieces() const
+	{
+		return occupied;
+	}
+
+	Bitboard Pieces(Color color) const
+	{
+		return byColor[color];
+	}
+
+	Bitboard Pieces(Color color, PieceType type) const
+	{
+		return byColorType[color][type];
+	}
+
+	Bitboard Pieces(PieceType type) const
+	{
+		return byColorType[WHITE][type] | byColorType[BLACK][type];
+	}
+
+	Square KingSquare(Color color) const
+	{
+		return Lsb(byColorType[color][KING]);
+	}
+
+	Color SideToMove() const
+	{
+		return sideToMove;
+	}
+
+	int CastlingRights() const
+	{
+		return castlingRights;
+	}
+
+	Square EpSquare() const
+	{
+		return epSquare;
+	}
+
+	int HalfmoveClock() const
+	{
+		return halfmoveClock;
+	}
+
+	int FullmoveNumber() const
+	{
+		return fullmoveNumber;
+	}
+
+	// Castling is encoded as a king move to an empty square, so it never counts.
+	bool IsCapture(Move move) const
+	{
+		return !Empty(move.To()) || move.Type() == MoveType::EN_PASSANT;
+	}
+
+	// Zobrist key of pieces, side to move, castling rights and en passant file, kept up to date by every board change.
+	uint64_t Key() const
+	{
+		return key;
+	}
+
+	// Zobrist key of the pawns of both colors only.
+	uint64_t PawnKey() const
+	{
+		return pawnKey;
+	}
+
+	// Identifies the material balance: how many pieces of each type and color there are, not where.
+	uint64_t MaterialKey() const
+	{
+		return materialKey;
+	}
+
+	// How many earlier positions of the game equal this one. Only the positions since the last
+	// capture or pawn move can, so the scan is bounded by the halfmove clock, and the filter
+	// answers the usual case of no repetition with a single probe.
+	int RepetitionCount() const;
+
+	// Forgets the plies before the last capture or pawn move, which no later position can repeat,
+	// and beyond the last hundred, past which the fifty-move rule has drawn anyway. Leaves room on
+	// the undo stack in a long game; the forgotten moves can no longer be taken back.
+	void TrimHistory();
+
+	// Fifty moves by each side without a capture or pawn move. A checkmate delivered on the
+	// hundredth ply still wins, which is for the caller to rule out.
+	bool IsFiftyMoveDraw() const
+	{
+		return halfmoveClock >= 100;
+	}
+
+	// Key() recomputed from scratch, to verify the incremental updates.
+	uint64_t ComputeKey() const;
+
+	// All pieces of either color attacking the square, given the occupancy.
+	Bitboard AttackersTo(Square square, Bitboard occupancy) const;
+
+	bool IsAttacked(Square square, Color attacker) const
+	{
+		return (AttackersTo(square, Pieces()) & Pieces(attacker)) != 0;
+	}
+
+	// Squares attacked by the color. Sliders see through the enemy king, so a king can
+	// never step back along the ray of a slider checking it: every square outside the map
+	// is safe for the enemy king.
+	Bitboard Attacked(Color color) const
+	{
+		return attacked[color];
+	}
+
+	// Squares attacked by at least two pieces of the color.
+	Bitboard AttackedTwice(Color color) const
+	{
+		return attackedTwice[color];
+	}
+
+	// How many pieces of the color attack the square, seeing through the enemy king like Attacked.
+	// Computed on demand from a few table lookups rather than kept per square: the maps above
+	// answer the common questions, and a move would have to update every count it touches.
+	int AttackerCount(Square square, Color color) const
+	{
+		return PopCount(AttackersTo(square, occupied ^ Pieces(~color, KING)) & Pieces(color));
+	}
+
+	// Enemy pieces giving check to the side to move.
+	Bitboard Checkers() const
+	{
+		return checkers;
+	}
+
+	bool InCheck() const
+	{
+		return checkers != 0;
+	}
+
+	// Static exchange evaluation: whether the move wins at least threshold centipawns once all
+	// captures on its destination are played out, least valuable attacker first. Sliders behind
+	// the capturing pieces join in as they are uncovered. Pins are ignored, and promotions,
+	// en passant and castling count as even trades.
+	bool See(Move move, int threshold) const;
+
+private:
+	// Brings the attack maps and checkers up to date after a move of the given side that changed
+	// the occupancy of the given squares, see the definition.
+	void UpdateAttacks(Color moved, Bitboard changed, bool captured);
+	void RebuildAttacks(Color color);
+	void UpdateCheckers();
+
+private:
+	Bitboard byColorType[COLOR_NB][PIECE_TYPE_NB];
+	Bitboard byColor[COLOR_NB];
+	Bitboard occupied;
+	PieceCode board[SQUARE_NB];
+	Color sideToMove;
+	int castlingRights;
+	Square epSquare;
+	int halfmoveClock;
+	int fullmoveNumber;
+	int gamePly;
+	uint64_t key;
+	uint64_t pawnKey;
+	uint64_t materialKey;
+	// Kept with the rest of the state: saved in the undo record by MakeMove and restored by UnmakeMove.
+	Bitboard attacked[COLOR_NB];
+	Bitboard attackedTwice[COLOR_NB];
+	Bitboard checkers;
+	UndoInfo history[MaxGamePly];
+	// How many positions of the game, the current one included, hash to each slot.
+	uint16_t repetitionFilter[RepetitionFilterSize];
+	const TranspositionTable* prefetchTable = nullptr;
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+// xorshift64* generator. Always seeded explicitly so that tables built from it are reproducible.
+class Prng
+{
+public:
+	explicit Prng(uint64_t seed) : state{ seed } {}
+
+	uint64_t Next()
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 2685821657736338717ULL;
+	}
+
+	// Numbers with roughly 8 of 64 bits set.
+	uint64_t Sparse()
+	{
+		return Next() & Next() & Next();
+	}
+
+private:
+	uint64_t state;
+};
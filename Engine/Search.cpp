@@ -0,0 +1,788 @@
+#include "Search.h"
+#include <algorithm>
+#include <cmath>
+#include "Evaluate.h"
+
+namespace
+{
+	// How often, in nodes, the clock and node limit are looked at. Even a slow thread gets through
+	// this many well within a millisecond, which bounds how late a stop is noticed.
+	constexpr uint64_t CheckInterval = 512;
+	// How often an infinite or ponder search with nothing left to search looks for a stop or the ponder hit.
+	constexpr std::chrono::milliseconds ReleaseWaitSleep{ 1 };
+	constexpr int AspirationDelta = 25;
+	// Aspiration windows only pay off once the scores of consecutive iterations are stable.
+	constexpr int AspirationMinDepth = 5;
+	constexpr int RazorMaxDepth = 3;
+	constexpr int RazorMargin = 250;
+	constexpr int ReverseFutilityMaxDepth = 6;
+	constexpr int ReverseFutilityMargin = 90;
+	constexpr int FutilityMaxDepth = 6;
+	constexpr int FutilityMargin = 100;
+	constexpr int LateMovePruningMaxDepth = 4;
+	constexpr int NullMoveMinDepth = 3;
+	constexpr int LateMoveReductionMinDepth = 3;
+
+	// Late move reductions grow with the logarithms of both the depth and the move number.
+	struct ReductionTable
+	{
+		ReductionTable()
+		{
+			for (int depth = 1; depth < 64; depth++)
+				for (int moveCount = 1; moveCount < 64; moveCount++)
+					values[depth][moveCount] = int(0.75 + std::log(depth) * std::log(moveCount) / 2.25);
+		}
+
+		int Get(int depth, int moveCount) const
+		{
+			return values[std::min(depth, 63)][std::min(moveCount, 63)];
+		}
+
+		int values[64][64] = {};
+	};
+
+	const ReductionTable Reductions;
+
+	// Quiescence search skips a capture that cannot lift the score to alpha even with this much
+	// positional gain on top of the captured piece.
+	constexpr int DeltaMargin = 200;
+
+	// Helper i skips the depths where (depth + SkipPhase[i]) / SkipSize[i] is odd, so that at any
+	// time the helpers are spread over the current iteration and the next few.
+	constexpr int SkipCount = 20;
+	constexpr int SkipSize[SkipCount] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+	constexpr int SkipPhase[SkipCount] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+	// ABDADA only defers moves whose subtrees are worth handing to another thread.
+	constexpr int DeferMinDepth = 3;
+
+	uint64_t MoveHash(uint64_t key, Move move)
+	{
+		return key ^ (uint64_t(move.Raw()) + 1) * 0x9E3779B97F4A7C15ULL;
+	}
+
+	// Mate scores count plies from the root, but the table is shared between nodes at any ply,
+	// so they are stored relative to the node instead.
+	int ScoreToTable(int score, int ply)
+	{
+		if (score >= ValueMateInMaxPly)
+			return score + ply;
+		if (score <= ValueMatedInMaxPly)
+			return score - ply;
+		return score;
+	}
+
+	int ScoreFromTable(int score, int ply)
+	{
+		if (score >= ValueMateInMaxPly)
+			return score - ply;
+		if (score <= ValueMatedInMaxPly)
+			return score + ply;
+		return score;
+	}
+}
+
+// One search thread. Everything written at every node lives here rather than in Search, and
+// each worker is a separate cache-line aligned allocation, so threads never share a line they write.
+class alignas(64) SearchWorker
+{
+public:
+	SearchWorker(Search& search, int id) :
+		search{ search }, id{ id }
+	{
+		Clear();
+	}
+
+public:
+	void Clear()
+	{
+		history.Clear();
+		continuationHistory.Clear();
+		for (auto& slots : killers)
+			slots[0] = slots[1] = NoMove;
+		for (auto& byPiece : counterMoves)
+			for (Move& move : byPiece)
+				move = NoMove;
+	}
+
+	// Iterative deepening until the depth limit or a stop. The main worker, id 0, watches the
+	// limits and reports its iterations; the helpers only feed the tables.
+	void Think(const Position& root, const Search::InfoCallback* onInfo);
+
+	uint64_t Nodes() const
+	{
+		return nodes.load(std::memory_order_relaxed);
+	}
+
+	// Depth, score and principal variation of the last completed iteration.
+	const SearchInfo& Result() const
+	{
+		return result;
+	}
+
+	uint64_t Cutoffs() const
+	{
+		return cutoffs;
+	}
+
+	uint64_t FirstMoveCutoffs() const
+	{
+		return firstMoveCutoffs;
+	}
+
+private:
+	int AspirationSearch(int depth, int previousScore);
+	int AlphaBeta(int alpha, int beta, int depth, int ply);
+	int Quiescence(int alpha, int beta, int ply);
+	void UpdateQuietStats(Move move, int ply, int depth, const Move* triedQuiets, int triedCount);
+	bool ShouldStop();
+
+	// The continuation history of the move played back plies before ply, if there is one and it
+	// was not a null move.
+	PieceToHistory* Continuation(int ply, int back)
+	{
+		if (ply < back || playedPiece[ply - back] == NO_PIECE)
+			return nullptr;
+		return &continuationHistory.At(playedPiece[ply - back], playedMove[ply - back].To());
+	}
+
+	Move& CounterMove(int ply)
+	{
+		return counterMoves[playedPiece[ply - 1]][playedMove[ply - 1].To()];
+	}
+
+	bool HasCounterMove(int ply) const
+	{
+		return ply > 0 && playedPiece[ply - 1] != NO_PIECE;
+	}
+
+	bool GivesCheck(Move move)
+	{
+		position.MakeMove(move);
+		bool check = position.InCheck();
+		position.UnmakeMove(move);
+		return check;
+	}
+
+	std::atomic<uint64_t>& BusySlot(uint64_t moveHash) const
+	{
+		return search.busyMoves[moveHash & (Search::BusyMoveSlots - 1)];
+	}
+
+private:
+	Search& search;
+	const int id;
+	Position position;
+	// Written by this worker only, read by the main worker for the node limit and the reports.
+	std::atomic<uint64_t> nodes{ 0 };
+	bool stopped = false;
+	Move rootBest = NoMove;
+	SearchInfo result;
+	uint64_t cutoffs = 0;
+	uint64_t firstMoveCutoffs = 0;
+
+	// The move played at each ply of the current line, and the piece that played it; NO_PIECE for a null move.
+	Move playedMove[MaxPly];
+	PieceCode playedPiece[MaxPly];
+
+	History history;
+	ContinuationHistory continuationHistory;
+	// Indexed by the piece and destination of the move replied to.
+	Move counterMoves[PIECE_CODE_NB][SQUARE_NB];
+	Move killers[MaxPly][2];
+	// Triangular principal variation table: pv[ply] is the best line found from that ply on.
+	Move pv[MaxPly][MaxPly];
+	int pvLength[MaxPly];
+};
+
+void SearchWorker::Think(const Position& root, const Search::InfoCallback* onInfo)
+{
+	position = root;
+	// The root may come from a caller that never trimmed, such as a long game in the GUI.
+	if (position.GamePly() + MaxPly >= Position::MaxGamePly)
+		position.TrimHistory();
+	position.SetPrefetchTable(&search.table);
+	stopped = false;
+	nodes.store(0, std::memory_order_relaxed);
+	cutoffs = firstMoveCutoffs = 0;
+	for (auto& slots : killers)
+		slots[0] = slots[1] = NoMove;
+
+	// Should not even the first iteration finish, any legal move is better than none.
+	MoveList rootMoves;
+	GenerateLegalMoves(position, rootMoves);
+	rootBest = rootMoves[0];
+	result = SearchInfo();
+	result.pv.push_back(rootBest);
+
+	int score = 0;
+	for (int depth = 1; depth <= search.limits.depth && depth < MaxPly; depth++)
+	{
+		if (id > 0 && search.smpMode == SmpMode::LAZY)
+		{
+			int skip = (id - 1) % SkipCount;
+			if ((depth + SkipPhase[skip]) / SkipSize[skip] % 2)
+				continue;
+		}
+
+		score = AspirationSearch(depth, score);
+		if (stopped)
+			break;
+
+		bool bestMoveChanged = result.depth > 0 && pv[0][0] != rootBest;
+		rootBest = pv[0][0];
+		result.depth = depth;
+		result.score = score;
+		result.pv.assign(pv[0], pv[0] + pvLength[0]);
+		if (onInfo != nullptr && *onInfo)
+		{
+			SearchInfo info = result;
+			info.nodes = search.Nodes();
+			info.time = search.Elapsed();
+			info.nps = info.time > 0 ? info.nodes * 1000 / uint64_t(info.time) : 0;
+			info.hashfull = search.table.Hashfull();
+			(*onInfo)(info);
+		}
+
+		// Search::Think stops the helpers once the main worker returns.
+		if (id == 0)
+		{
+			search.timeManager.OnIteration(bestMoveChanged);
+			if (!search.Pondering() && search.timeManager.SoftLimitReached(Search::Clock::now()))
+				break;
+		}
+	}
+}
+
+// Searches a narrow window around the previous iteration's score and widens whichever side fails.
+int SearchWorker::AspirationSearch(int depth, int previousScore)
+{
+	if (depth < AspirationMinDepth)
+		return AlphaBeta(-ValueInfinite, ValueInfinite, depth, 0);
+
+	int delta = AspirationDelta;
+	int alpha = std::max(previousScore - delta, -ValueInfinite);
+	int beta = std::min(previousScore + delta, ValueInfinite);
+	while (true)
+	{
+		int score = AlphaBeta(alpha, beta, depth, 0);
+		if (stopped)
+			return score;
+		if (score <= alpha)
+			alpha = std::max(score - delta, -ValueInfinite);
+		else if (score >= beta)
+			beta = std::min(score + delta, ValueInfinite);
+		else
+			return score;
+		delta += delta;
+	}
+}
+
+int SearchWorker::AlphaBeta(int alpha, int beta, int depth, int ply)
+{
+	pvLength[ply] = 0;
+	// Checks are searched one ply deeper so that the horizon is never in check.
+	bool inCheck = position.InCheck();
+	if (inCheck)
+		depth++;
+	if (depth <= 0)
+		return Quiescence(alpha, beta, ply);
+
+	nodes.store(nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	if (ShouldStop())
+		return 0;
+
+	if (ply > 0)
+	{
+		// In check the fifty-move rule waits for the move loop to tell mate from a draw.
+		if (position.RepetitionCount() > 0 || (position.IsFiftyMoveDraw() && !inCheck))
+			return ValueDraw;
+		if (ply >= MaxPly - 1)
+			return Evaluate(position);
+	}
+
+	bool pvNode = beta - alpha > 1;
+	uint64_t key = position.Key();
+	Move hashMove = NoMove;
+	TTData entry;
+	if (search.table.Probe(key, entry))
+	{
+		hashMove = entry.move;
+		int tableScore = ScoreFromTable(entry.score, ply);
+		// Cutoffs are left out of PV nodes so that the principal variation stays intact.
+		if (!pvNode && entry.depth >= depth && (entry.bound & (tableScore >= beta ? BOUND_LOWER : BOUND_UPPER)))
+			return tableScore;
+	}
+	// The root's entry may have been replaced, but the last iteration's best move is known.
+	if (ply == 0)
+		hashMove = rootBest;
+
+	const SearchFeatures& features = search.features;
+	bool prunable = !pvNode && !inCheck;
+	int staticEval = prunable ? Evaluate(position) : -ValueInfinite;
+	if (prunable)
+	{
+		if (features.razoring && depth <= RazorMaxDepth && staticEval + RazorMargin * depth <= alpha)
+		{
+			int score = Quiescence(alpha, beta, ply);
+			if (score <= alpha)
+				return score;
+		}
+
+		if (features.reverseFutility && depth <= ReverseFutilityMaxDepth && staticEval - ReverseFutilityMargin * depth >= beta
+			&& beta > ValueMatedInMaxPly && beta < ValueMateInMaxPly)
+		{
+			return staticEval;
+		}
+
+		Color us = position.SideToMove();
+		bool hasPieces = (position.Pieces(us) & ~position.Pieces(us, PAWN) & ~position.Pieces(us, KING)) != 0;
+		bool afterNullMove = ply > 0 && playedPiece[ply - 1] == NO_PIECE;
+		if (features.nullMove && depth >= NullMoveMinDepth && staticEval >= beta && hasPieces && !afterNullMove)
+		{
+			int reduction = 3 + depth / 4;
+			playedMove[ply] = NoMove;
+			playedPiece[ply] = NO_PIECE;
+			position.MakeNullMove();
+			int score = -AlphaBeta(-beta, -beta + 1, depth - 1 - reduction, ply + 1);
+			position.UnmakeNullMove();
+			if (stopped)
+				return 0;
+			// A mate found after passing is not proven, the pass being illegal.
+			if (score >= beta)
+				return score >= ValueMateInMaxPly ? beta : score;
+		}
+	}
+
+	int originalAlpha = alpha;
+	Move bestMove = NoMove;
+	const PieceToHistory* continuations[2] = { Continuation(ply, 1), Continuation(ply, 2) };
+	Move counterMove = HasCounterMove(ply) ? CounterMove(ply) : NoMove;
+	MovePicker picker(position, hashMove, killers[ply], counterMove, history, continuations);
+	Move triedQuiets[MaxMoves];
+	int triedCount = 0;
+	int moveCount = 0;
+	int bestScore = -ValueInfinite;
+	bool abdada = search.smpMode == SmpMode::ABDADA && search.Threads() > 1 && depth >= DeferMinDepth;
+	Move deferred[MaxMoves];
+	int deferredCount = 0;
+	int deferredIndex = 0;
+
+	while (true)
+	{
+		// Once the picker runs dry, the moves passed over because another thread was on them.
+		Move move = picker.Next();
+		bool firstPass = move != NoMove;
+		if (!firstPass)
+		{
+			if (deferredIndex == deferredCount)
+				break;
+			move = deferred[deferredIndex++];
+		}
+
+		bool quiet = !position.IsCapture(move) && move.Type() != MoveType::PROMOTION;
+		if (prunable && quiet && moveCount > 0 && bestScore > ValueMatedInMaxPly)
+		{
+			bool late = features.lateMovePruning && depth <= LateMovePruningMaxDepth && moveCount >= 3 + depth * depth;
+			bool futile = features.futility && depth <= FutilityMaxDepth && staticEval + FutilityMargin * (depth + 1) <= alpha;
+			if ((late || futile) && !GivesCheck(move))
+			{
+				moveCount++;
+				continue;
+			}
+		}
+
+		// The first move of a node is searched by every thread, as in young brothers wait.
+		uint64_t moveHash = 0;
+		if (abdada && firstPass && moveCount > 0)
+		{
+			moveHash = MoveHash(key, move);
+			if (BusySlot(moveHash).load(std::memory_order_relaxed) == moveHash)
+			{
+				deferred[deferredCount++] = move;
+				continue;
+			}
+			BusySlot(moveHash).store(moveHash, std::memory_order_relaxed);
+		}
+
+		playedMove[ply] = move;
+		playedPiece[ply] = position.PieceOn(move.From());
+		position.MakeMove(move);
+		moveCount++;
+
+		// Principal variation search: after the first move, only prove that the others are no better
+		// with a null window, and search again with the full window when one turns out to be. Late
+		// quiet moves are tried at reduced depth first.
+		int score;
+		if (moveCount == 1)
+		{
+			score = -AlphaBeta(-beta, -alpha, depth - 1, ply + 1);
+		}
+		else
+		{
+			int reduction = 0;
+			if (features.lateMoveReductions && depth >= LateMoveReductionMinDepth && quiet && !inCheck && !position.InCheck())
+				reduction = std::clamp(Reductions.Get(depth, moveCount) - int(pvNode), 0, depth - 2);
+
+			score = -AlphaBeta(-alpha - 1, -alpha, depth - 1 - reduction, ply + 1);
+			if (score > alpha && reduction > 0)
+				score = -AlphaBeta(-alpha - 1, -alpha, depth - 1, ply + 1);
+			if (score > alpha && pvNode)
+				score = -AlphaBeta(-beta, -alpha, depth - 1, ply + 1);
+		}
+		position.UnmakeMove(move);
+
+		if (moveHash != 0)
+		{
+			uint64_t expected = moveHash;
+			BusySlot(moveHash).compare_exchange_strong(expected, 0, std::memory_order_relaxed);
+		}
+
+		if (stopped)
+			return 0;
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			if (score > alpha)
+			{
+				alpha = score;
+				bestMove = move;
+				pv[ply][0] = move;
+				std::copy(pv[ply + 1], pv[ply + 1] + pvLength[ply + 1], pv[ply] + 1);
+				pvLength[ply] = pvLength[ply + 1] + 1;
+				if (alpha >= beta)
+				{
+					cutoffs++;
+					firstMoveCutoffs += moveCount == 1;
+					if (quiet)
+						UpdateQuietStats(move, ply, depth, triedQuiets, triedCount);
+					break;
+				}
+			}
+		}
+		if (quiet)
+			triedQuiets[triedCount++] = move;
+	}
+
+	if (moveCount == 0)
+		return inCheck ? -ValueMate + ply : ValueDraw;
+	if (position.IsFiftyMoveDraw())
+		return ValueDraw;
+
+	Bound bound = bestScore >= beta ? BOUND_LOWER : bestScore > originalAlpha ? BOUND_EXACT : BOUND_UPPER;
+	search.table.Store(key, bestMove, ScoreToTable(bestScore, ply), depth, bound);
+	return bestScore;
+}
+
+// Searches captures only, until the position is quiet enough for the static evaluation to be
+// trusted. The side to move may stand pat on the evaluation, since it need not capture; in check
+// it may not, and every evasion is searched.
+int SearchWorker::Quiescence(int alpha, int beta, int ply)
+{
+	nodes.store(nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	if (ShouldStop())
+		return 0;
+
+	bool inCheck = position.InCheck();
+	if (position.RepetitionCount() > 0 || (position.IsFiftyMoveDraw() && !inCheck))
+		return ValueDraw;
+	if (ply >= MaxPly - 1)
+		return Evaluate(position);
+
+	uint64_t key = position.Key();
+	Move hashMove = NoMove;
+	TTData entry;
+	if (search.table.Probe(key, entry))
+	{
+		hashMove = entry.move;
+		int tableScore = ScoreFromTable(entry.score, ply);
+		if (entry.bound & (tableScore >= beta ? BOUND_LOWER : BOUND_UPPER))
+			return tableScore;
+	}
+
+	int originalAlpha = alpha;
+	int standPat = -ValueInfinite;
+	int bestScore = -ValueInfinite;
+	if (!inCheck)
+	{
+		standPat = bestScore = Evaluate(position);
+		if (standPat >= beta)
+			return standPat;
+		alpha = std::max(alpha, standPat);
+	}
+
+	// Losing captures are filtered out by the picker's SEE test.
+	MovePicker picker(position, hashMove, history);
+	Move bestMove = NoMove;
+	int moveCount = 0;
+	for (Move move = picker.Next(); move != NoMove; move = picker.Next())
+	{
+		moveCount++;
+		if (!inCheck && move.Type() != MoveType::PROMOTION)
+		{
+			PieceType victim = move.Type() == MoveType::EN_PASSANT ? PAWN : TypeOf(position.PieceOn(move.To()));
+			if (standPat + PieceValue[victim] + DeltaMargin <= alpha)
+				continue;
+		}
+
+		position.MakeMove(move);
+		int score = -Quiescence(-beta, -alpha, ply + 1);
+		position.UnmakeMove(move);
+
+		if (stopped)
+			return 0;
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			if (score > alpha)
+			{
+				alpha = score;
+				bestMove = move;
+				if (alpha >= beta)
+					break;
+			}
+		}
+	}
+
+	if (inCheck && moveCount == 0)
+		return -ValueMate + ply;
+
+	Bound bound = bestScore >= beta ? BOUND_LOWER : bestScore > originalAlpha ? BOUND_EXACT : BOUND_UPPER;
+	search.table.Store(key, bestMove, ScoreToTable(bestScore, ply), 0, bound);
+	return bestScore;
+}
+
+// The quiet move that caused a cutoff becomes a killer and the countermove of the move before, and
+// gains history; the quiet moves tried before it lose some, so that the ordering learns which one
+// to try first next time.
+void SearchWorker::UpdateQuietStats(Move move, int ply, int depth, const Move* triedQuiets, int triedCount)
+{
+	const SearchFeatures& features = search.features;
+	if (features.killers && killers[ply][0] != move)
+	{
+		killers[ply][1] = killers[ply][0];
+		killers[ply][0] = move;
+	}
+	if (features.counterMoves && HasCounterMove(ply))
+		CounterMove(ply) = move;
+
+	Color us = position.SideToMove();
+	PieceToHistory* continuations[2] = { Continuation(ply, 1), Continuation(ply, 2) };
+	int bonus = std::min(depth * depth, 400);
+	auto update = [&](Move quiet, int amount)
+	{
+		if (features.history)
+			history.Update(us, quiet, amount);
+		if (!features.continuationHistory)
+			return;
+		for (PieceToHistory* continuation : continuations)
+		{
+			if (continuation != nullptr)
+				continuation->Update(position.PieceOn(quiet.From()), quiet.To(), amount);
+		}
+	};
+
+	update(move, bonus);
+	for (int i = 0; i < triedCount; i++)
+		update(triedQuiets[i], -bonus);
+}
+
+// Only the main worker looks at the limits; it stops the helpers through the shared flag.
+bool SearchWorker::ShouldStop()
+{
+	if (stopped)
+		return true;
+	if (Nodes() % CheckInterval == 0)
+	{
+		if (id == 0 && ((search.limits.nodes && search.Nodes() >= search.limits.nodes)
+			|| (!search.Pondering() && search.timeManager.HardLimitReached(Search::Clock::now()))))
+		{
+			search.Stop();
+		}
+		stopped = id == 0 ? search.StopRequested() : search.stopRequested.load(std::memory_order_relaxed);
+	}
+	return stopped;
+}
+
+Search::Search() :
+	busyMoves{ new std::atomic<uint64_t>[BusyMoveSlots] }
+{
+	for (size_t i = 0; i < BusyMoveSlots; i++)
+		busyMoves[i].store(0, std::memory_order_relaxed);
+	SetThreads(1);
+}
+
+Search::~Search()
+{
+	Stop();
+	Wait();
+}
+
+SearchInfo Search::Run(const Position& root, const SearchLimits& searchLimits, const InfoCallback& onInfo)
+{
+	stopRequested = false;
+	ponderHit = false;
+	return Think(root, searchLimits, onInfo);
+}
+
+SearchInfo Search::Run(const Position& root, const SearchLimits& searchLimits, const InfoCallback& onInfo, const SearchControl& searchControl)
+{
+	control = &searchControl;
+	SearchInfo info = Run(root, searchLimits, onInfo);
+	control = nullptr;
+	return info;
+}
+
+void Search::Start(const Position& root, const SearchLimits& searchLimits, InfoCallback onInfo, InfoCallback onDone)
+{
+	Wait();
+	// Cleared here rather than on the new thread, so that a Stop issued right after Start is not lost.
+	stopRequested = false;
+	ponderHit = false;
+	thread = std::thread([this, root, searchLimits, onInfo, onDone]()
+	{
+		SearchInfo info = Think(root, searchLimits, onInfo);
+		if (onDone)
+			onDone(info);
+	});
+}
+
+void Search::Wait()
+{
+	if (thread.joinable())
+		thread.join();
+}
+
+void Search::Clear()
+{
+	table.Clear();
+	for (auto& worker : workers)
+		worker->Clear();
+}
+
+void Search::SetThreads(int count)
+{
+	count = std::max(count, 1);
+	workers.resize(std::min(workers.size(), size_t(count)));
+	while (int(workers.size()) < count)
+		workers.push_back(std::make_unique<SearchWorker>(*this, int(workers.size())));
+}
+
+SearchInfo Search::Think(const Position& root, const SearchLimits& searchLimits, const InfoCallback& onInfo)
+{
+	limits = searchLimits;
+	startTime = Clock::now();
+	rootColor = root.SideToMove();
+	pondering = limits.ponder;
+	if (pondering)
+		timeManager = TimeManager();
+	else
+		StartClock(startTime);
+	table.NewSearch();
+
+	SearchInfo info;
+	MoveList rootMoves;
+	GenerateLegalMoves(root, rootMoves);
+	if (rootMoves.Empty())
+	{
+		WaitUntilReleased();
+		info.score = root.InCheck() ? -ValueMate : ValueDraw;
+		return info;
+	}
+
+	std::vector<std::thread> helpers;
+	for (size_t i = 1; i < workers.size(); i++)
+	{
+		SearchWorker* worker = workers[i].get();
+		helpers.emplace_back([worker, &root]() { worker->Think(root, nullptr); });
+	}
+	workers[0]->Think(root, &onInfo);
+	WaitUntilReleased();
+	// The main worker is done, by a limit or by reaching the depth, and so are the helpers.
+	Stop();
+	for (std::thread& helper : helpers)
+		helper.join();
+
+	// A helper that completed a deeper iteration with a better score has the better move.
+	const SearchWorker* best = workers[0].get();
+	for (const auto& worker : workers)
+	{
+		if (worker->Result().depth > best->Result().depth && worker->Result().score > best->Result().score)
+			best = worker.get();
+	}
+
+	info = best->Result();
+	for (const auto& worker : workers)
+	{
+		info.cutoffs += worker->Cutoffs();
+		info.firstMoveCutoffs += worker->FirstMoveCutoffs();
+	}
+	info.nodes = Nodes();
+	info.time = Elapsed();
+	info.nps = info.time > 0 ? info.nodes * 1000 / uint64_t(info.time) : 0;
+	info.hashfull = table.Hashfull();
+	return info;
+}
+
+void Search::StartClock(Clock::time_point start)
+{
+	// An infinite search has no budget, whatever clock came with it.
+	if (limits.infinite)
+	{
+		timeManager = TimeManager();
+		return;
+	}
+	timeManager.Init(start, limits.time[rootColor], limits.increment[rootColor], limits.movesToGo, limits.moveTime, moveOverhead);
+}
+
+// Main thread only. Looks for the ponder hit, and on it starts the clock.
+bool Search::Pondering()
+{
+	if (pondering && (ponderHit.load(std::memory_order_acquire)
+		|| (control != nullptr && control->ponderHit && control->ponderHit())))
+	{
+		pondering = false;
+		StartClock(Clock::now());
+	}
+	return pondering;
+}
+
+// Main thread only. Stop, or the control, has asked the search to stop; the helpers follow through the flag.
+bool Search::StopRequested()
+{
+	if (control != nullptr && control->stopped && control->stopped())
+		Stop();
+	return stopRequested.load(std::memory_order_relaxed);
+}
+
+// Main thread only. An infinite or ponder search that has run out of things to search still waits:
+// its move may not be reported before a stop, or before the ponder hit.
+void Search::WaitUntilReleased()
+{
+	while (!StopRequested() && (limits.infinite || Pondering()))
+		std::this_thread::sleep_for(ReleaseWaitSleep);
+}
+
+uint64_t Search::Nodes() const
+{
+	uint64_t total = 0;
+	for (const auto& worker : workers)
+		total += worker->Nodes();
+	return total;
+}
+
+int64_t Search::Elapsed() const
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime).count();
+}
+
+std::string ScoreToUci(int score)
+{
+	if (score >= ValueMateInMaxPly)
+		return "mate " + std::to_string((ValueMate - score + 1) / 2);
+	if (score <= ValueMatedInMaxPly)
+		return "mate " + std::to_string(-(ValueMate + score) / 2);
+	return "cp " + std::to_string(score);
+}
@@ -0,0 +1,233 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MovePicker.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+
+constexpr int MaxPly = 128;
+
+constexpr int ValueDraw = 0;
+constexpr int ValueMate = 32000;
+constexpr int ValueInfinite = 32001;
+// Scores beyond these bounds are mates, counted in plies from the root.
+constexpr int ValueMateInMaxPly = ValueMate - MaxPly;
+constexpr int ValueMatedInMaxPly = -ValueMateInMaxPly;
+
+struct SearchLimits
+{
+	int depth = MaxPly - 1;
+	// Zero means no limit.
+	uint64_t nodes = 0;
+	// Milliseconds, zero means no limit.
+	int64_t moveTime = 0;
+	// The clocks, in milliseconds, from which TimeManager budgets the move when there is no move time.
+	int64_t time[COLOR_NB] = {};
+	int64_t increment[COLOR_NB] = {};
+	// Moves until the next time control, zero if the rest of the game is played on this clock.
+	int movesToGo = 0;
+	// Searching on the opponent's time, on the move expected from them. The clock only starts at
+	// Search::PonderHit, and until then the search does not end by itself.
+	bool ponder = false;
+	// Searching until Search::Stop, whatever the other limits; the result is not reported before.
+	bool infinite = false;
+};
+
+// Lets the caller of Search::Run decide by itself when the search is to stop and when the move it
+// ponders on has been played, e.g. by the id of the search a request was meant for. Unlike Stop and
+// PonderHit, whose flags Run clears, such an answer cannot be lost to a search that has yet to start.
+// Polled by the main search thread, often enough for a stop to take effect as promptly as Stop's.
+struct SearchControl
+{
+	std::function<bool()> stopped;
+	std::function<bool()> ponderHit;
+};
+
+// What the search has found after a completed iteration.
+struct SearchInfo
+{
+	int depth = 0;
+	int score = 0;
+	uint64_t nodes = 0;
+	// Milliseconds since the search started.
+	int64_t time = 0;
+	uint64_t nps = 0;
+	// Permille of the transposition table in use by this search.
+	int hashfull = 0;
+	// Beta cutoffs outside quiescence search, and how many of them the first move tried produced.
+	uint64_t cutoffs = 0;
+	uint64_t firstMoveCutoffs = 0;
+	std::vector<Move> pv;
+};
+
+// Search features that can be switched off, to measure what each of them is worth.
+struct SearchFeatures
+{
+	// Move ordering. Captures are always ordered by MVV-LVA; these order the quiet moves.
+	bool killers = true;
+	bool history = true;
+	bool counterMoves = true;
+	bool continuationHistory = true;
+
+	// Selectivity, none of it at PV nodes or in check.
+	// Passes the turn and cuts off if the reduced search still beats beta. Not without pieces
+	// besides pawns, where passing can be the only good move, nor twice in a row.
+	bool nullMove = true;
+	// Searches late quiet moves less deep, and again at full depth only if they beat alpha.
+	bool lateMoveReductions = true;
+	// Near the horizon, cuts off when the static evaluation beats beta by a depth-dependent margin.
+	bool reverseFutility = true;
+	// Near the horizon, skips quiet moves when the static evaluation is far below alpha.
+	bool futility = true;
+	// Near the horizon, skips the quiet moves after the first few.
+	bool lateMovePruning = true;
+	// Near the horizon, drops into quiescence search when the static evaluation is far below alpha.
+	bool razoring = true;
+};
+
+// How several threads share the work.
+enum class SmpMode
+{
+	// Every thread searches the whole tree at staggered depths; they cooperate through the table only.
+	LAZY,
+	// Every thread searches the same depth, and after the first move of a node passes over the moves
+	// another thread is busy with, coming back to them once the rest have been searched.
+	ABDADA
+};
+
+class SearchWorker;
+
+// Negamax alpha-beta with iterative deepening, principal variation search and aspiration windows.
+// A search runs until a limit is hit or Stop is called; the best move comes from the last completed
+// iteration. One Search object runs one search at a time.
+//
+// With more than one thread the search is Lazy SMP: every thread searches the same root, the
+// helpers skipping some depths so that they spread over different iterations, and the threads
+// share nothing but the transposition table, through which they hand each other their results.
+// ABDADA mode adds a small shared table of the moves being searched, see SmpMode.
+class Search
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	static constexpr int64_t DefaultMoveOverhead = 30;
+	using InfoCallback = std::function<void(const SearchInfo&)>;
+
+public:
+	Search();
+	~Search();
+
+	Search(const Search&) = delete;
+	Search& operator=(const Search&) = delete;
+
+public:
+	// Searches a copy of the position, the main thread being the calling one. onInfo, if set, is called
+	// after every iteration the main thread completes. Returns the final report, whose pv is empty only
+	// if there is no legal move.
+	SearchInfo Run(const Position& root, const SearchLimits& limits, const InfoCallback& onInfo = {});
+	// Like Run, and the search also stops or ends pondering when the control says so.
+	SearchInfo Run(const Position& root, const SearchLimits& limits, const InfoCallback& onInfo, const SearchControl& control);
+
+	// Like Run, but on a background thread that calls onDone with the final report. Any earlier
+	// background search must have finished, see Wait.
+	void Start(const Position& root, const SearchLimits& limits, InfoCallback onInfo, InfoCallback onDone);
+
+	// Blocks until the search begun by Start has returned.
+	void Wait();
+
+	// Makes the running search return as soon as possible. Safe to call from any thread, even
+	// before the thread begun by Start has got going.
+	void Stop()
+	{
+		stopRequested = true;
+	}
+
+	// The opponent has played the move the running ponder search expected: from now on it is a
+	// normal search, its time counted from this moment. Safe to call from any thread, and ignored
+	// by a search that is not pondering.
+	void PonderHit()
+	{
+		ponderHit = true;
+	}
+
+	// Forgets the transposition table, killers and history of earlier searches, for a new game.
+	void Clear();
+
+	// Resizes and clears the transposition table. No search may be running.
+	void SetHashSize(size_t megabytes)
+	{
+		table.Resize(megabytes);
+	}
+
+	// Number of search threads, at least one. New threads start with empty heuristics. No search may be running.
+	void SetThreads(int count);
+
+	int Threads() const
+	{
+		return int(workers.size());
+	}
+
+	// No search may be running.
+	void SetSmpMode(SmpMode mode)
+	{
+		smpMode = mode;
+	}
+
+	// Switched-off heuristics stop learning, so Clear first for a clean comparison. No search may be running.
+	void SetFeatures(const SearchFeatures& searchFeatures)
+	{
+		features = searchFeatures;
+	}
+
+	const SearchFeatures& Features() const
+	{
+		return features;
+	}
+
+	// Milliseconds kept on the clock for the time it takes a move to reach it. No search may be running.
+	void SetMoveOverhead(int64_t milliseconds)
+	{
+		moveOverhead = milliseconds;
+	}
+
+private:
+	friend class SearchWorker;
+
+	static constexpr size_t BusyMoveSlots = 32768;
+
+	SearchInfo Think(const Position& root, const SearchLimits& limits, const InfoCallback& onInfo);
+	void StartClock(Clock::time_point start);
+	bool Pondering();
+	bool StopRequested();
+	void WaitUntilReleased();
+	uint64_t Nodes() const;
+	int64_t Elapsed() const;
+
+private:
+	TranspositionTable table;
+	SmpMode smpMode = SmpMode::LAZY;
+	SearchFeatures features;
+	// ABDADA: the position key XOR move hash of a move some thread is searching, per slot.
+	std::unique_ptr<std::atomic<uint64_t>[]> busyMoves;
+	std::vector<std::unique_ptr<SearchWorker>> workers;
+	SearchLimits limits;
+	TimeManager timeManager;
+	int64_t moveOverhead = DefaultMoveOverhead;
+	Clock::time_point startTime;
+	std::atomic<bool> stopRequested{ false };
+	std::atomic<bool> ponderHit{ false };
+	// Set during Run only.
+	const SearchControl* control = nullptr;
+	// Main thread only: the search is still pondering.
+	bool pondering = false;
+	Color rootColor = WHITE;
+	std::thread thread;
+};
+
+// UCI score notation: "cp <centipawns>" or "mate <moves>", negative when the side to move gets mated.
+std::string ScoreToUci(int score);
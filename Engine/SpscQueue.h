@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread. Neither side
+// ever waits: Push fails when the queue is full and Pop when it is empty. Each index is written
+// by one side only and sits on its own cache line, together with that side's cached copy of the
+// other index, so the sides touch each other's line only when the cached copy runs out.
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "the capacity must be a power of two");
+
+public:
+	SpscQueue() :
+		slots{ new T[Capacity] }
+	{
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+public:
+	// Producer only.
+	template<typename U>
+	bool Push(U&& value)
+	{
+		size_t tail = producer.index.load(std::memory_order_relaxed);
+		if (tail - producer.otherIndex == Capacity)
+		{
+			producer.otherIndex = consumer.index.load(std::memory_order_acquire);
+			if (tail - producer.otherIndex == Capacity)
+				return false;
+		}
+		slots[tail & Mask] = std::forward<U>(value);
+		producer.index.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only.
+	bool Pop(T& value)
+	{
+		size_t head = consumer.index.load(std::memory_order_relaxed);
+		if (head == consumer.otherIndex)
+		{
+			consumer.otherIndex = producer.index.load(std::memory_order_acquire);
+			if (head == consumer.otherIndex)
+				return false;
+		}
+		value = std::move(slots[head & Mask]);
+		consumer.index.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	static constexpr size_t Mask = Capacity - 1;
+
+	// The indices only ever grow; a slot is the index modulo the capacity.
+	struct alignas(64) Side
+	{
+		std::atomic<size_t> index{ 0 };
+		size_t otherIndex = 0;
+	};
+
+	Side producer;
+	Side consumer;
+	std::unique_ptr<T[]> slots;
+};
@@ -0,0 +1,52 @@
+#include "TimeManager.h"
+#include <algorithm>
+
+namespace
+{
+	// Without movestogo the game is assumed to last this many more moves.
+	constexpr int DefaultMovesToGo = 30;
+	constexpr int MaxMovesToGo = 50;
+	// The hard limit is this many times the soft one, but never more than this share of the clock,
+	// unless it is the last move before the time control.
+	constexpr int64_t HardLimitScale = 5;
+	constexpr int64_t HardLimitShareNumerator = 2;
+	constexpr int64_t HardLimitShareDenominator = 5;
+}
+
+void TimeManager::Init(Clock::time_point searchStart, int64_t time, int64_t increment, int movesToGo, int64_t moveTime, int64_t overhead)
+{
+	start = searchStart;
+	instability = 0.0;
+	active = moveTime > 0 || time > 0;
+	fixed = moveTime > 0;
+	if (fixed)
+	{
+		softLimit = hardLimit = moveTime;
+	}
+	else if (active)
+	{
+		int64_t available = std::max<int64_t>(time - overhead, 1);
+		int count = movesToGo > 0 ? std::min(movesToGo, MaxMovesToGo) : DefaultMovesToGo;
+		softLimit = available / count + increment * 3 / 4;
+		hardLimit = count == 1 ? available
+			: std::min(softLimit * HardLimitScale, available * HardLimitShareNumerator / HardLimitShareDenominator);
+		hardLimit = std::max<int64_t>(hardLimit, 1);
+		softLimit = std::clamp<int64_t>(softLimit, 1, hardLimit);
+	}
+	hardDeadline = start + std::chrono::milliseconds(hardLimit);
+}
+
+void TimeManager::OnIteration(bool bestMoveChanged)
+{
+	instability = instability / 2 + (bestMoveChanged ? 1.0 : 0.0);
+}
+
+// A best move that is still changing has not been searched enough, so up to about three times
+// the soft limit is spent on it; the hard limit caps that anyway.
+bool TimeManager::SoftLimitReached(Clock::time_point now) const
+{
+	if (!active || fixed)
+		return false;
+	double elapsed = std::chrono::duration<double, std::milli>(now - start).count();
+	return elapsed >= double(softLimit) * (1.0 + instability);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// Splits the time left on the clock into a budget for one move. The soft limit is checked between
+// iterations: no new one is started past it, and it is stretched while the best move keeps changing.
+// The hard limit aborts the iteration in progress, so the clock never runs out.
+class TimeManager
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+public:
+	// All times in milliseconds. A fixed move time makes both limits equal to it; without either
+	// a clock or a move time, Active stays false and the search only stops on its other limits.
+	// The overhead is kept in hand for the time it takes the move to reach the clock.
+	void Init(Clock::time_point start, int64_t time, int64_t increment, int movesToGo, int64_t moveTime, int64_t overhead);
+
+	bool Active() const
+	{
+		return active;
+	}
+
+	// Called by the main thread after each completed iteration.
+	void OnIteration(bool bestMoveChanged);
+
+	// Whether another iteration is worth starting.
+	bool SoftLimitReached(Clock::time_point now) const;
+
+	bool HardLimitReached(Clock::time_point now) const
+	{
+		return active && now >= hardDeadline;
+	}
+
+	int64_t SoftLimit() const
+	{
+		return softLimit;
+	}
+
+	int64_t HardLimit() const
+	{
+		return hardLimit;
+	}
+
+private:
+	Clock::time_point start;
+	Clock::time_point hardDeadline;
+	int64_t softLimit = 0;
+	int64_t hardLimit = 0;
+	// Best move changes, halved every iteration so that only recent ones count.
+	double instability = 0.0;
+	bool active = false;
+	bool fixed = false;
+};
@@ -0,0 +1,234 @@
+#include "TranspositionTable.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "advapi32.lib")
+#endif
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+	// Transparent huge pages are 2 MB on x86-64; the table is aligned to that so that all of it can be backed by them.
+	constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+	uint64_t Pack(Move move, int score, int depth, Bound bound, int generation)
+	{
+		return uint64_t(move.Raw())
+			| uint64_t(uint16_t(int16_t(score))) << 16
+			| uint64_t(std::clamp(depth, 0, 255)) << 32
+			| uint64_t(bound) << 40
+			| uint64_t(generation) << 42;
+	}
+
+	Move MoveOf(uint64_t data)
+	{
+		return Move(uint16_t(data));
+	}
+
+	int DepthOf(uint64_t data)
+	{
+		return int((data >> 32) & 0xFF);
+	}
+
+	int GenerationOf(uint64_t data)
+	{
+		return int((data >> 42) & 0x3F);
+	}
+
+#if defined(_WIN32)
+	// Large pages need the "Lock pages in memory" privilege. An account that holds it still has to
+	// enable it in the process token, which is all this does; it fails if the account lacks it.
+	bool EnableLockMemoryPrivilege()
+	{
+		HANDLE token;
+		if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+			return false;
+		TOKEN_PRIVILEGES privileges{};
+		privileges.PrivilegeCount = 1;
+		privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+		bool enabled = LookupPrivilegeValue(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+			&& AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+			// AdjustTokenPrivileges also succeeds when the token does not hold the privilege.
+			&& GetLastError() == ERROR_SUCCESS;
+		CloseHandle(token);
+		return enabled;
+	}
+#endif
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+{
+	Resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+	Free();
+}
+
+void TranspositionTable::Resize(size_t megabytes)
+{
+	Free();
+	count = 1;
+	while (count * 2 * sizeof(Bucket) <= std::max<size_t>(megabytes, 1) * 1024 * 1024)
+		count *= 2;
+	mask = count - 1;
+	Allocate(count * sizeof(Bucket));
+	for (size_t i = 0; i < count; i++)
+		new (&buckets[i]) Bucket();
+	Clear();
+}
+
+void TranspositionTable::Clear()
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		for (Entry& entry : buckets[i].entries)
+		{
+			entry.keyXorData.store(0, std::memory_order_relaxed);
+			entry.data.store(0, std::memory_order_relaxed);
+		}
+	}
+	generation = 0;
+}
+
+// Large pages are tried first: with 4 KB pages nearly every probe of a big table also misses the TLB.
+void TranspositionTable::Allocate(size_t bytes)
+{
+#if defined(_WIN32)
+	size_t largePage = GetLargePageMinimum();
+	void* memory = nullptr;
+	if (largePage > 0 && EnableLockMemoryPrivilege())
+	{
+		size_t rounded = (bytes + largePage - 1) / largePage * largePage;
+		memory = VirtualAlloc(nullptr, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+	}
+	if (memory == nullptr)
+		memory = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	mapped = true;
+#elif defined(__linux__)
+	// Explicit huge pages only exist if the administrator reserved some; otherwise ask for
+	// transparent ones on memory aligned to a huge page.
+	void* memory = nullptr;
+#if defined(MAP_HUGETLB)
+	size_t rounded = (bytes + HugePageSize - 1) / HugePageSize * HugePageSize;
+	memory = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (memory == MAP_FAILED)
+		memory = nullptr;
+	mapped = memory != nullptr;
+#endif
+	if (memory == nullptr)
+	{
+		size_t alignment = bytes >= HugePageSize ? HugePageSize : alignof(Bucket);
+		memory = std::aligned_alloc(alignment, bytes);
+#if defined(MADV_HUGEPAGE)
+		if (memory != nullptr)
+			madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+	}
+#else
+	void* memory = std::aligned_alloc(std::max<size_t>(alignof(Bucket), bytes >= HugePageSize ? HugePageSize : 0), bytes);
+	mapped = false;
+#endif
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	buckets = static_cast<Bucket*>(memory);
+}
+
+void TranspositionTable::Free()
+{
+	if (buckets == nullptr)
+		return;
+#if defined(_WIN32)
+	VirtualFree(buckets, 0, MEM_RELEASE);
+#else
+#if defined(__linux__)
+	if (mapped)
+		munmap(buckets, (count * sizeof(Bucket) + HugePageSize - 1) / HugePageSize * HugePageSize);
+	else
+#endif
+		std::free(buckets);
+#endif
+	buckets = nullptr;
+	mapped = false;
+}
+
+bool TranspositionTable::Probe(uint64_t key, TTData& result) const
+{
+	const Bucket& bucket = buckets[key & mask];
+	for (const Entry& entry : bucket.entries)
+	{
+		uint64_t data = entry.data.load(std::memory_order_relaxed);
+		uint64_t check = entry.keyXorData.load(std::memory_order_relaxed);
+		if ((check ^ data) != key || data == 0)
+			continue;
+		result.move = MoveOf(data);
+		result.score = int16_t(uint16_t(data >> 16));
+		result.depth = DepthOf(data);
+		result.bound = Bound((data >> 40) & 3);
+		return true;
+	}
+	return false;
+}
+
+// Within the bucket the entry of the same position is reused; otherwise the one that is worth
+// least, counting each search of age as eight plies of depth, so old deep results do not linger.
+void TranspositionTable::Store(uint64_t key, Move move, int score, int depth, Bound bound)
+{
+	Bucket& bucket = buckets[key & mask];
+	Entry* replace = nullptr;
+	int replaceValue = INT_MAX;
+	for (Entry& entry : bucket.entries)
+	{
+		uint64_t data = entry.data.load(std::memory_order_relaxed);
+		uint64_t check = entry.keyXorData.load(std::memory_order_relaxed);
+		if (data != 0 && (check ^ data) == key)
+		{
+			// A much shallower bound from the current search is worth less than the result it would overwrite.
+			if (bound != BOUND_EXACT && GenerationOf(data) == generation && depth < DepthOf(data) - 3)
+				return;
+			if (move == NoMove)
+				move = MoveOf(data);
+			replace = &entry;
+			break;
+		}
+
+		int age = (generation - GenerationOf(data)) & GenerationMask;
+		int value = data == 0 ? INT_MIN : DepthOf(data) - 8 * age;
+		if (value < replaceValue)
+		{
+			replace = &entry;
+			replaceValue = value;
+		}
+	}
+
+	uint64_t data = Pack(move, score, depth, bound, generation);
+	replace->keyXorData.store(key ^ data, std::memory_order_relaxed);
+	replace->data.store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::Hashfull() const
+{
+	size_t sample = std::min<size_t>(count, 250);
+	int used = 0;
+	for (size_t i = 0; i < sample; i++)
+	{
+		for (const Entry& entry : buckets[i].entries)
+		{
+			uint64_t data = entry.data.load(std::memory_order_relaxed);
+			if (data != 0 && GenerationOf(data) == generation)
+				used++;
+		}
+	}
+	return int(used * 1000 / (sample * EntriesPerBucket));
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "Types.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+// How a stored score relates to the true value of the position.
+enum Bound
+{
+	BOUND_NONE,
+	// The search failed low: the true value is at most the score.
+	BOUND_UPPER,
+	// The search failed high: the true value is at least the score.
+	BOUND_LOWER,
+	BOUND_EXACT = BOUND_UPPER | BOUND_LOWER
+};
+
+struct TTData
+{
+	Move move;
+	int score;
+	int depth;
+	Bound bound;
+};
+
+// Search results shared by all threads, keyed by the position's Zobrist key. Entries are grouped
+// in buckets of one cache line, so a probe costs at most one miss, and MakeMove prefetches that
+// line as soon as the new key is known. Like PerftHashTable, each entry stores the key XORed with
+// its data, so writes need no lock: a torn entry fails verification and reads as a miss.
+class TranspositionTable
+{
+public:
+	static constexpr size_t DefaultMegabytes = 16;
+
+public:
+	explicit TranspositionTable(size_t megabytes = DefaultMegabytes);
+	~TranspositionTable();
+
+	TranspositionTable(const TranspositionTable&) = delete;
+	TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+public:
+	// Reallocates to the largest power of two number of buckets that fits, and clears.
+	// No search may be using the table.
+	void Resize(size_t megabytes);
+	void Clear();
+
+	// Starts a new search: entries left by earlier ones become the first to be replaced.
+	void NewSearch()
+	{
+		generation = (generation + 1) & GenerationMask;
+	}
+
+	bool Probe(uint64_t key, TTData& data) const;
+	// An entry of the same position keeps its move if the new result has none.
+	void Store(uint64_t key, Move move, int score, int depth, Bound bound);
+
+	void Prefetch(uint64_t key) const
+	{
+		const void* address = &buckets[key & mask];
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_prefetch((const char*)address, _MM_HINT_T0);
+#elif defined(__GNUC__)
+		__builtin_prefetch(address);
+#else
+		(void)address;
+#endif
+	}
+
+	// Permille of a sample of entries written by the current search, for UCI's hashfull.
+	int Hashfull() const;
+
+	size_t Megabytes() const
+	{
+		return count * sizeof(Bucket) / (1024 * 1024);
+	}
+
+private:
+	static constexpr int EntriesPerBucket = 4;
+	static constexpr int GenerationMask = 0x3F;
+
+	// data packs the move in bits 0-15, the score in 16-31, the depth in 32-39, the bound in 40-41
+	// and the generation in 42-47.
+	struct Entry
+	{
+		std::atomic<uint64_t> keyXorData;
+		std::atomic<uint64_t> data;
+	};
+
+	struct alignas(64) Bucket
+	{
+		Entry entries[EntriesPerBucket];
+	};
+
+	static_assert(sizeof(Entry) == 16 && sizeof(Bucket) == 64, "a bucket must fill exactly one cache line");
+
+	void Allocate(size_t bytes);
+	void Free();
+
+	Bucket* buckets = nullptr;
+	size_t count = 0;
+	size_t mask = 0;
+	// How the memory was obtained, and so how it is to be freed.
+	bool mapped = false;
+	int generation = 0;
+};
@@ -0,0 +1,246 @@
+#pragma once
+#include <cstdint>
+
+using Bitboard = uint64_t;
+
+enum Color : int
+{
+	WHITE,
+	BLACK,
+	COLOR_NB = 2
+};
+
+enum PieceType : int
+{
+	PAWN,
+	KNIGHT,
+	BISHOP,
+	ROOK,
+	QUEEN,
+	KING,
+	PIECE_TYPE_NB = 6,
+	NO_PIECE_TYPE = 6
+};
+
+// A piece type together with its color, as stored in the mailbox.
+enum PieceCode : int
+{
+	W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK, W_QUEEN, W_KING,
+	B_PAWN, B_KNIGHT, B_BISHOP, B_ROOK, B_QUEEN, B_KING,
+	NO_PIECE,
+	PIECE_CODE_NB = 12
+};
+
+// Little-endian rank-file mapping: a1 = 0, b1 = 1, ..., h8 = 63.
+enum Square : int
+{
+	SQ_A1, SQ_B1, SQ_C1, SQ_D1, SQ_E1, SQ_F1, SQ_G1, SQ_H1,
+	SQ_A2, SQ_B2, SQ_C2, SQ_D2, SQ_E2, SQ_F2, SQ_G2, SQ_H2,
+	SQ_A3, SQ_B3, SQ_C3, SQ_D3, SQ_E3, SQ_F3, SQ_G3, SQ_H3,
+	SQ_A4, SQ_B4, SQ_C4, SQ_D4, SQ_E4, SQ_F4, SQ_G4, SQ_H4,
+	SQ_A5, SQ_B5, SQ_C5, SQ_D5, SQ_E5, SQ_F5, SQ_G5, SQ_H5,
+	SQ_A6, SQ_B6, SQ_C6, SQ_D6, SQ_E6, SQ_F6, SQ_G6, SQ_H6,
+	SQ_A7, SQ_B7, SQ_C7, SQ_D7, SQ_E7, SQ_F7, SQ_G7, SQ_H7,
+	SQ_A8, SQ_B8, SQ_C8, SQ_D8, SQ_E8, SQ_F8, SQ_G8, SQ_H8,
+	SQUARE_NB = 64,
+	SQ_NONE = 64
+};
+
+enum File : int
+{
+	FILE_A, FILE_B, FILE_C, FILE_D, FILE_E, FILE_F, FILE_G, FILE_H,
+	FILE_NB = 8
+};
+
+enum Rank : int
+{
+	RANK_1, RANK_2, RANK_3, RANK_4, RANK_5, RANK_6, RANK_7, RANK_8,
+	RANK_NB = 8
+};
+
+enum Direction : int
+{
+	NORTH = 8,
+	EAST = 1,
+	SOUTH = -8,
+	WEST = -1,
+	NORTH_EAST = NORTH + EAST,
+	NORTH_WEST = NORTH + WEST,
+	SOUTH_EAST = SOUTH + EAST,
+	SOUTH_WEST = SOUTH + WEST
+};
+
+enum CastlingRight : int
+{
+	NO_CASTLING = 0,
+	WHITE_OO = 1,
+	WHITE_OOO = 2,
+	BLACK_OO = 4,
+	BLACK_OOO = 8,
+	ALL_CASTLING = 15
+};
+
+constexpr Color operator~(Color c)
+{
+	return Color(c ^ 1);
+}
+
+constexpr Square MakeSquare(File file, Rank rank)
+{
+	return Square(rank * 8 + file);
+}
+
+constexpr File FileOf(Square square)
+{
+	return File(square & 7);
+}
+
+constexpr Rank RankOf(Square square)
+{
+	return Rank(square >> 3);
+}
+
+constexpr bool IsValid(Square square)
+{
+	return square >= SQ_A1 && square <= SQ_H8;
+}
+
+// Flips the square vertically, so that white-relative tables can be used for black.
+constexpr Square RelativeSquare(Color color, Square square)
+{
+	return Square(square ^ (color * 56));
+}
+
+constexpr Rank RelativeRank(Color color, Rank rank)
+{
+	return Rank(rank ^ (color * 7));
+}
+
+constexpr Direction PawnPush(Color color)
+{
+	return color == WHITE ? NORTH : SOUTH;
+}
+
+constexpr PieceCode MakePiece(Color color, PieceType type)
+{
+	return PieceCode(color * 6 + type);
+}
+
+constexpr PieceType TypeOf(PieceCode piece)
+{
+	return piece == NO_PIECE ? NO_PIECE_TYPE : PieceType(piece % 6);
+}
+
+constexpr Color ColorOf(PieceCode piece)
+{
+	return Color(piece / 6);
+}
+
+constexpr Square operator+(Square square, Direction direction)
+{
+	return Square(int(square) + int(direction));
+}
+
+constexpr Square operator-(Square square, Direction direction)
+{
+	return Square(int(square) - int(direction));
+}
+
+inline Square& operator++(Square& square)
+{
+	return square = Square(int(square) + 1);
+}
+
+inline File& operator++(File& file)
+{
+	return file = File(int(file) + 1);
+}
+
+inline Rank& operator++(Rank& rank)
+{
+	return rank = Rank(int(rank) + 1);
+}
+
+inline Rank& operator--(Rank& rank)
+{
+	return rank = Rank(int(rank) - 1);
+}
+
+inline PieceType& operator++(PieceType& type)
+{
+	return type = PieceType(int(type) + 1);
+}
+
+// Material values in centipawns, indexed by PieceType. The king is never traded, so it counts as nothing.
+constexpr int PieceValue[PIECE_TYPE_NB + 1] = { 100, 320, 330, 500, 900, 0, 0 };
+
+enum class MoveType
+{
+	NORMAL,
+	PROMOTION,
+	EN_PASSANT,
+	CASTLING
+};
+
+// Packed into 16 bits: from in bits 0-5, to in bits 6-11, promotion piece minus knight in 12-13
+// and the move type in 14-15. Castling is encoded as the king's move, e.g. e1g1.
+class Move
+{
+public:
+	// Left uninitialized so that move lists need no clearing.
+	Move() = default;
+
+	constexpr Move(Square from, Square to, MoveType type = MoveType::NORMAL, PieceType promotion = KNIGHT) :
+		data{ uint16_t(from | to << 6 | (promotion - KNIGHT) << 12 | int(type) << 14) }
+	{
+	}
+
+	// From the packed form returned by Raw().
+	explicit constexpr Move(uint16_t raw) :
+		data{ raw }
+	{
+	}
+
+public:
+	constexpr Square From() const
+	{
+		return Square(data & 0x3F);
+	}
+
+	constexpr Square To() const
+	{
+		return Square((data >> 6) & 0x3F);
+	}
+
+	constexpr MoveType Type() const
+	{
+		return MoveType(data >> 14);
+	}
+
+	// Only meaningful for promotions.
+	constexpr PieceType Promotion() const
+	{
+		return PieceType(((data >> 12) & 3) + KNIGHT);
+	}
+
+	constexpr uint16_t Raw() const
+	{
+		return data;
+	}
+
+	constexpr bool operator==(const Move& other) const
+	{
+		return data == other.data;
+	}
+
+	constexpr bool operator!=(const Move& other) const
+	{
+		return data != other.data;
+	}
+
+private:
+	uint16_t data;
+};
+
+// Stands in for a missing move, e.g. an empty killer slot. a1a1 is never legal.
+constexpr Move NoMove{ SQ_A1, SQ_A1 };
@@ -0,0 +1,35 @@
+#include "Zobrist.h"
+#include "Random.h"
+
+uint64_t Zobrist::pieceSquare[PIECE_CODE_NB][SQUARE_NB];
+uint64_t Zobrist::castling[ALL_CASTLING + 1];
+uint64_t Zobrist::enPassant[FILE_NB];
+uint64_t Zobrist::sideToMove;
+
+void InitZobrist()
+{
+	Prng rng{ 1070372 };
+
+	for (int piece = 0; piece < PIECE_CODE_NB; piece++)
+	{
+		for (int square = 0; square < SQUARE_NB; square++)
+			Zobrist::pieceSquare[piece][square] = rng.Next();
+	}
+
+	// Each right gets its own key, and combinations are the XOR of their parts.
+	uint64_t rightKeys[4] = { rng.Next(), rng.Next(), rng.Next(), rng.Next() };
+	for (int rights = 0; rights <= ALL_CASTLING; rights++)
+	{
+		Zobrist::castling[rights] = 0;
+		for (int bit = 0; bit < 4; bit++)
+		{
+			if (rights & (1 << bit))
+				Zobrist::castling[rights] ^= rightKeys[bit];
+		}
+	}
+
+	for (int file = 0; file < FILE_NB; file++)
+		Zobrist::enPassant[file] = rng.Next();
+
+	Zobrist::sideToMove = rng.Next();
+}
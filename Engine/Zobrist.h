@@ -0,0 +1,14 @@
+#pragma once
+#include "Types.h"
+
+// Random keys XORed together to identify a position.
+struct Zobrist
+{
+	static uint64_t pieceSquare[PIECE_CODE_NB][SQUARE_NB];
+	static uint64_t castling[ALL_CASTLING + 1];
+	static uint64_t enPassant[FILE_NB];
+	static uint64_t sideToMove;
+};
+
+// Fills the key tables. Must be called once before any position key is used.
+void InitZobrist();
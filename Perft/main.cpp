@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MoveGen.h"
+#include "Perft.h"
+
+namespace
+{
+	struct ReferencePosition
+	{
+		const char* fen;
+		std::vector<uint64_t> nodes;
+	};
+
+	// Published perft results, nodes[i] being the count for depth i + 1. A zero means no published count.
+	const std::vector<ReferencePosition> ReferencePositions =
+	{
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", { 20, 400, 8902, 197281, 4865609, 119060324, 3195901860ULL } },
+		{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", { 48, 2039, 97862, 4085603, 193690690 } },
+		{ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", { 14, 191, 2812, 43238, 674624, 11030083, 178633661 } },
+		{ "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", { 6, 264, 9467, 422333, 15833292 } },
+		{ "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", { 44, 1486, 62379, 2103487, 89941194 } },
+		{ "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", { 46, 2079, 89890, 3894594, 164075551 } },
+		// Pins, discovered checks through en passant, castling through or out of check and underpromotions.
+		{ "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", { 0, 0, 0, 0, 0, 1134888 } },
+		{ "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1", { 0, 0, 0, 0, 0, 1015133 } },
+		{ "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", { 0, 0, 0, 0, 0, 1440467 } },
+		{ "5k2/8/8/8/8/8/8/4K2R w K - 0 1", { 0, 0, 0, 0, 0, 661072 } },
+		{ "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1", { 0, 0, 0, 0, 0, 803711 } },
+		{ "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", { 0, 0, 0, 1274206 } },
+		{ "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", { 0, 0, 0, 1720476 } },
+		{ "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", { 0, 0, 0, 0, 0, 3821001 } },
+		{ "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1", { 0, 0, 0, 0, 1004658 } },
+		{ "4k3/1P6/8/8/8/8/K7/8 w - - 0 1", { 0, 0, 0, 0, 0, 217342 } },
+		{ "8/P1k5/K7/8/8/8/8/8 w - - 0 1", { 0, 0, 0, 0, 0, 92683 } },
+		{ "K1k5/8/P7/8/8/8/8/8 w - - 0 1", { 0, 0, 0, 0, 0, 2217 } },
+		{ "8/k1P5/8/1K6/8/8/8/8 w - - 0 1", { 0, 0, 0, 0, 0, 0, 567584 } },
+		{ "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", { 0, 0, 0, 23527 } }
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	double SecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	void PrintSpeed(uint64_t nodes, double seconds)
+	{
+		std::printf("Time: %.3f s, %.2f Mnps\n", seconds, seconds > 0 ? nodes / seconds / 1e6 : 0.0);
+	}
+
+	uint64_t Total(const std::vector<DivideEntry>& entries)
+	{
+		uint64_t total = 0;
+		for (const DivideEntry& entry : entries)
+			total += entry.nodes;
+		return total;
+	}
+
+	int RunDivide(const std::string& fen, int depth, const PerftOptions& options)
+	{
+		Position position;
+		if (!position.SetFromFen(fen))
+		{
+			std::printf("invalid fen: %s\n", fen.c_str());
+			return 1;
+		}
+
+		Clock::time_point start = Clock::now();
+		std::vector<DivideEntry> entries = PerftDivide(position, depth, options);
+		double seconds = SecondsSince(start);
+		for (const DivideEntry& entry : entries)
+		{
+			std::printf("%s: %llu\n", MoveToUci(entry.move).c_str(), (unsigned long long)entry.nodes);
+		}
+		uint64_t total = Total(entries);
+
+		std::printf("\nNodes searched: %llu\n", (unsigned long long)total);
+		PrintSpeed(total, seconds);
+		return 0;
+	}
+
+	// Checks every reference position up to maxDepth. Exits non-zero on the first mismatch.
+	int RunSuite(int maxDepth, const PerftOptions& options)
+	{
+		uint64_t totalNodes = 0;
+		Clock::time_point start = Clock::now();
+		for (const ReferencePosition& reference : ReferencePositions)
+		{
+			Position position;
+			position.SetFromFen(reference.fen);
+			int checked = 0;
+			for (int depth = 1; depth <= maxDepth && depth <= (int)reference.nodes.size(); depth++)
+			{
+				uint64_t expected = reference.nodes[depth - 1];
+				if (expected == 0)
+					continue;
+				uint64_t nodes = Total(PerftDivide(position, depth, options));
+				checked++;
+				totalNodes += nodes;
+				if (nodes != expected)
+				{
+					std::printf("FAIL %s depth %d: %llu, expected %llu\n", reference.fen, depth, (unsigned long long)nodes, (unsigned long long)expected);
+					return 1;
+				}
+			}
+			std::printf("%s %s\n", checked ? "ok  " : "skip", reference.fen);
+		}
+
+		std::printf("\nNodes searched: %llu\n", (unsigned long long)totalNodes);
+		PrintSpeed(totalNodes, SecondsSince(start));
+		return 0;
+	}
+
+	void PrintUsage()
+	{
+		std::printf(
+			"usage:\n"
+			"  Perft [options] <depth> [fen]    node count per root move (divide) and in total, start position by default\n"
+			"  Perft [options] suite [depth]    check the reference positions up to depth (default 4)\n"
+			"options:\n"
+			"  --threads <n>    worker threads (default: all hardware threads)\n"
+			"  --hash <mb>      shared perft hash table size, 0 to disable (default 64)\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	InitBitboards();
+	InitZobrist();
+
+	PerftOptions options;
+	options.threads = std::max(1u, std::thread::hardware_concurrency());
+	int hashMegabytes = 64;
+
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			options.threads = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--hash") == 0 && i + 1 < argc)
+			hashMegabytes = std::max(0, std::atoi(argv[++i]));
+		else
+			args.push_back(argv[i]);
+	}
+
+	if (args.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::unique_ptr<PerftHashTable> table;
+	if (hashMegabytes > 0)
+	{
+		table.reset(new PerftHashTable((size_t)hashMegabytes));
+		options.table = table.get();
+	}
+
+	if (args[0] == "suite")
+	{
+		return RunSuite(args.size() > 1 ? std::atoi(args[1].c_str()) : 4, options);
+	}
+
+	int depth = std::atoi(args[0].c_str());
+	if (depth < 1)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::string fen = StartFen;
+	if (args.size() > 1)
+	{
+		fen.clear();
+		for (size_t i = 1; i < args.size(); i++)
+		{
+			fen += (i > 1 ? " " : "") + args[i];
+		}
+	}
+	return RunDivide(fen, depth, options);
+}
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include "MoveGen.h"
+#include "Search.h"
+
+namespace
+{
+	constexpr size_t MaxHashMegabytes = 65536;
+	constexpr int MaxThreads = 1024;
+	constexpr int64_t MaxMoveOverhead = 5000;
+
+	struct FeatureOption
+	{
+		const char* name;
+		bool SearchFeatures::* flag;
+	};
+
+	// Check options switching search features, for A/B testing.
+	const FeatureOption FeatureOptions[] =
+	{
+		{ "Killers", &SearchFeatures::killers },
+		{ "History", &SearchFeatures::history },
+		{ "CounterMoves", &SearchFeatures::counterMoves },
+		{ "ContinuationHistory", &SearchFeatures::continuationHistory },
+		{ "NullMove", &SearchFeatures::nullMove },
+		{ "LateMoveReductions", &SearchFeatures::lateMoveReductions },
+		{ "ReverseFutility", &SearchFeatures::reverseFutility },
+		{ "Futility", &SearchFeatures::futility },
+		{ "LateMovePruning", &SearchFeatures::lateMovePruning },
+		{ "Razoring", &SearchFeatures::razoring }
+	};
+
+	// The search thread reports while the main thread may be answering isready.
+	std::mutex outputMutex;
+
+	void Send(const std::string& line)
+	{
+		std::lock_guard<std::mutex> lock(outputMutex);
+		std::printf("%s\n", line.c_str());
+		std::fflush(stdout);
+	}
+
+	std::string InfoLine(const SearchInfo& info)
+	{
+		std::string line = "info depth " + std::to_string(info.depth) + " score " + ScoreToUci(info.score)
+			+ " nodes " + std::to_string(info.nodes) + " nps " + std::to_string(info.nps)
+			+ " time " + std::to_string(info.time) + " hashfull " + std::to_string(info.hashfull) + " pv";
+		for (Move move : info.pv)
+			line += " " + MoveToUci(move);
+		return line;
+	}
+
+	// The expected reply goes along as the move to ponder on.
+	std::string BestMoveLine(const SearchInfo& info)
+	{
+		std::string line = "bestmove " + (info.pv.empty() ? std::string("0000") : MoveToUci(info.pv[0]));
+		if (info.pv.size() > 1)
+			line += " ponder " + MoveToUci(info.pv[1]);
+		return line;
+	}
+
+	Move ParseMove(const Position& position, const std::string& text)
+	{
+		MoveList moves;
+		GenerateLegalMoves(position, moves);
+		for (Move move : moves)
+		{
+			if (MoveToUci(move) == text)
+				return move;
+		}
+		return NoMove;
+	}
+
+	// position [startpos | fen <fen>] [moves <move>...]
+	void SetPosition(Position& position, std::istringstream& input)
+	{
+		std::string token;
+		std::string fen;
+		input >> token;
+		if (token == "startpos")
+		{
+			fen = StartFen;
+			input >> token;
+		}
+		else if (token == "fen")
+		{
+			while (input >> token && token != "moves")
+				fen += (fen.empty() ? "" : " ") + token;
+		}
+		if (!position.SetFromFen(fen))
+		{
+			Send("info string invalid fen " + fen);
+			position.SetFromFen(StartFen);
+			return;
+		}
+
+		while (input >> token)
+		{
+			Move move = ParseMove(position, token);
+			if (move == NoMove)
+			{
+				Send("info string illegal move " + token);
+				return;
+			}
+			position.MakeMove(move);
+			// Leave the search its MaxPly on the undo stack however long the game gets.
+			if (position.GamePly() + MaxPly >= Position::MaxGamePly)
+				position.TrimHistory();
+		}
+	}
+
+	// setoption name <name> value <value>
+	void SetOption(Search& search, std::istringstream& input)
+	{
+		std::string token, name, value;
+		input >> token;
+		while (input >> token && token != "value")
+			name += (name.empty() ? "" : " ") + token;
+		while (input >> token)
+			value += (value.empty() ? "" : " ") + token;
+
+		if (name == "Hash")
+			search.SetHashSize(std::clamp<size_t>(std::strtoull(value.c_str(), nullptr, 10), 1, MaxHashMegabytes));
+		else if (name == "Threads")
+			search.SetThreads(std::clamp(std::atoi(value.c_str()), 1, MaxThreads));
+		else if (name == "Move Overhead")
+			search.SetMoveOverhead(std::clamp<int64_t>(std::atoll(value.c_str()), 0, MaxMoveOverhead));
+		// Only tells the engine it may be asked to ponder, which needs no preparation.
+		else if (name == "Ponder")
+			return;
+		else if (name == "SMP Mode" && (value == "Lazy" || value == "ABDADA"))
+			search.SetSmpMode(value == "Lazy" ? SmpMode::LAZY : SmpMode::ABDADA);
+		else
+		{
+			for (const FeatureOption& option : FeatureOptions)
+			{
+				if (name == option.name && (value == "true" || value == "false"))
+				{
+					SearchFeatures features = search.Features();
+					features.*option.flag = value == "true";
+					search.SetFeatures(features);
+					return;
+				}
+			}
+			Send("info string unknown option " + name);
+		}
+	}
+
+	// go [ponder] [depth <n>] [nodes <n>] [movetime <ms>] [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [infinite]
+	SearchLimits ParseLimits(std::istringstream& input)
+	{
+		SearchLimits limits;
+		std::string token;
+		while (input >> token)
+		{
+			if (token == "ponder")
+				limits.ponder = true;
+			else if (token == "depth")
+				input >> limits.depth;
+			else if (token == "nodes")
+				input >> limits.nodes;
+			else if (token == "movetime")
+				input >> limits.moveTime;
+			else if (token == "wtime")
+				input >> limits.time[WHITE];
+			else if (token == "btime")
+				input >> limits.time[BLACK];
+			else if (token == "winc")
+				input >> limits.increment[WHITE];
+			else if (token == "binc")
+				input >> limits.increment[BLACK];
+			else if (token == "movestogo")
+				input >> limits.movesToGo;
+			else if (token == "infinite")
+				limits.infinite = true;
+		}
+		limits.depth = std::clamp(limits.depth, 1, MaxPly - 1);
+		return limits;
+	}
+}
+
+int main()
+{
+	InitBitboards();
+	InitZobrist();
+
+	// The killer, history and principal variation tables are too large for the stack.
+	std::unique_ptr<Search> search(new Search());
+	Position position;
+	position.SetFromFen(StartFen);
+
+	std::string line;
+	while (std::getline(std::cin, line))
+	{
+		std::istringstream input(line);
+		std::string command;
+		input >> command;
+
+		if (command == "uci")
+		{
+			Send("id name Chess");
+			Send("id author HippozHipos");
+			Send("option name Hash type spin default " + std::to_string(TranspositionTable::DefaultMegabytes) + " min 1 max " + std::to_string(MaxHashMegabytes));
+			Send("option name Threads type spin default 1 min 1 max " + std::to_string(MaxThreads));
+			Send("option name Move Overhead type spin default " + std::to_string(Search::DefaultMoveOverhead) + " min 0 max " + std::to_string(MaxMoveOverhead));
+			Send("option name Ponder type check default false");
+			Send("option name SMP Mode type combo default Lazy var Lazy var ABDADA");
+			for (const FeatureOption& option : FeatureOptions)
+				Send(std::string("option name ") + option.name + " type check default true");
+			Send("uciok");
+		}
+		else if (command == "isready")
+		{
+			Send("readyok");
+		}
+		else if (command == "setoption")
+		{
+			search->Stop();
+			search->Wait();
+			SetOption(*search, input);
+		}
+		else if (command == "ucinewgame")
+		{
+			search->Stop();
+			search->Wait();
+			search->Clear();
+		}
+		else if (command == "position")
+		{
+			search->Stop();
+			search->Wait();
+			SetPosition(position, input);
+		}
+		else if (command == "go")
+		{
+			search->Stop();
+			search->Wait();
+			SearchLimits limits = ParseLimits(input);
+			search->Start(position, limits,
+				[](const SearchInfo& info) { Send(InfoLine(info)); },
+				[](const SearchInfo& info) { Send(BestMoveLine(info)); });
+		}
+		else if (command == "ponderhit")
+		{
+			search->PonderHit();
+		}
+		else if (command == "stop")
+		{
+			search->Stop();
+			search->Wait();
+		}
+		else if (command == "quit")
+		{
+			break;
+		}
+	}
+	search->Stop();
+	search->Wait();
+	return 0;
+}